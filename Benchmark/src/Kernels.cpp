@@ -0,0 +1,90 @@
+#include "Kernels.h"
+
+// Internal parser headers
+#include <ByteReader.h>
+#include <Simd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#define MTrk 0x4d54726b
+
+// Calls function until minimumSeconds have passed and returns the seconds per call
+template<typename Function>
+static double Time(double minimumSeconds, Function function) {
+    uint32_t iterations = 0;
+    double seconds = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    do {
+        function();
+        iterations++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < minimumSeconds);
+
+    return seconds / iterations;
+}
+
+// Delta times as they appear in real files: mostly 1 byte, some 2, a few 3 and 4
+static std::vector<uint8_t> GenerateVariableLengths(size_t count) {
+    std::vector<uint8_t> data;
+    uint32_t state = 0x2545f491;
+
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        uint32_t bytes = state % 100 < 60 ? 1 : state % 100 < 90 ? 2 : state % 100 < 97 ? 3 : 4;
+        uint32_t value = (state >> 8) & ((1u << (7 * bytes)) - 1);
+
+        for (uint32_t b = bytes; b-- > 0;)
+            data.push_back((uint8_t)((value >> (7 * b)) & 0x7f) | (b ? 0x80 : 0));
+    }
+
+    data.resize(data.size() + 4);  // Padding for the last 4 byte load
+    return data;
+}
+
+static volatile int64_t s_Sink;  // Keeps the decoded values alive
+
+void RunKernelBenchmarks(double minimumSeconds) {
+    std::printf("\nKernels (%s)\n", Simd::GetInstructionSet());
+    std::printf("%-32s %12s %12s %10s\n", "kernel", "scalar", "vector", "speed-up");
+
+    const size_t valueCount = 1 << 20;
+    std::vector<uint8_t> lengths = GenerateVariableLengths(valueCount);
+
+    double scalar = Time(minimumSeconds, [&]() {
+        ByteReader reader(lengths.data(), lengths.size());
+        int64_t sum = 0;
+        for (size_t i = 0; i < valueCount; i++)
+            sum += reader.ReadVariableLengthValue<false, false>();
+        s_Sink = sum;
+    });
+    double vector = Time(minimumSeconds, [&]() {
+        ByteReader reader(lengths.data(), lengths.size());
+        int64_t sum = 0;
+        for (size_t i = 0; i < valueCount; i++)
+            sum += reader.ReadVariableLengthValue<false, true>();
+        s_Sink = sum;
+    });
+    std::printf("%-32s %9.2f ns %9.2f ns %9.2fx\n", "variable length (per value)",
+        scalar * 1e9 / valueCount, vector * 1e9 / valueCount, scalar / vector);
+
+    // A corrupt chunk length makes lenient parsing search the rest of the file for "MTrk"
+    // Note numbers and velocities, so the first byte of the tag ('M' is note 77) is common
+    std::vector<uint8_t> chunk(16 << 20);
+    for (size_t i = 0; i < chunk.size(); i++) {
+        chunk[i] = (uint8_t)(i * 2654435761u >> 13) & 0x7f;
+        if (chunk[i] == 'k')
+            chunk[i]--;  // Makes sure the tag only appears at the end
+    }
+    chunk.insert(chunk.end(), { 'M', 'T', 'r', 'k' });
+
+    scalar = Time(minimumSeconds, [&]() { s_Sink = Simd::FindTagScalar(chunk.data(), chunk.size(), MTrk); });
+    vector = Time(minimumSeconds, [&]() { s_Sink = Simd::FindTag(chunk.data(), chunk.size(), MTrk); });
+    std::printf("%-32s %7.2f GB/s %7.2f GB/s %9.2fx\n", "find track chunk",
+        chunk.size() / scalar / 1e9, chunk.size() / vector / 1e9, scalar / vector);
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Times the vectorised byte kernels against their scalar versions
+void RunKernelBenchmarks(double minimumSeconds);
@@ -0,0 +1,173 @@
+#include <MidiParser.h>
+
+#include "Kernels.h"
+#include "SyntheticMidi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+    #include <Psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+static uint64_t s_AllocCount = 0;
+
+void* operator new(size_t size) {
+    s_AllocCount++;
+    if (void* memory = malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+static size_t PeakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+        return (size_t)usage.ru_maxrss;  // Bytes on macOS
+    #else
+        return (size_t)usage.ru_maxrss * 1024;  // Kilobytes on Linux
+    #endif
+#endif
+}
+
+struct BenchmarkInput {
+    std::string Name;
+    std::vector<uint8_t> Data;
+};
+
+struct BenchmarkResult {
+    bool Success = false;
+    uint32_t Iterations = 0;
+    double Seconds = 0;
+    uint64_t Events = 0;  // Per parse
+    uint64_t Allocations = 0;  // Per parse, after the first
+};
+
+static uint64_t CountEvents(MidiParser& parser) {
+    uint64_t events = 0;
+    if (parser.GetOptions().Storage == TrackStorage::Compact) {
+        for (const CompactTrack& track : parser.GetCompactTracks())
+            events += track.GetEventCount();
+    } else {
+        for (MidiTrack& track : parser)
+            events += track.GetEventCount();
+    }
+    return events;
+}
+
+// Parses the input repeatedly for at least minimumSeconds
+static BenchmarkResult Run(const BenchmarkInput& input, const ParseOptions& options, double minimumSeconds) {
+    BenchmarkResult result;
+    MidiParser parser(options);
+
+    // The first parse warms up the parser's reusable buffers
+    result.Success = parser.Open(input.Data.data(), input.Data.size());
+    if (!result.Success)
+        return result;
+    result.Events = CountEvents(parser);
+
+    uint64_t allocations = s_AllocCount;
+    auto start = std::chrono::steady_clock::now();
+
+    do {
+        parser.Open(input.Data.data(), input.Data.size());
+        result.Iterations++;
+        result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (result.Seconds < minimumSeconds);
+
+    result.Allocations = (s_AllocCount - allocations) / result.Iterations;
+    return result;
+}
+
+static void PrintHeader() {
+    std::printf("%-32s %-9s %10s %10s %12s %10s %10s\n", "input", "storage", "size KB", "MB/s", "Mevents/s", "ns/event", "allocs");
+}
+
+static void PrintResult(const BenchmarkInput& input, const char* storage, const BenchmarkResult& result) {
+    if (!result.Success) {
+        std::printf("%-32s %-9s %10.1f %10s\n", input.Name.c_str(), storage, input.Data.size() / 1024.0, "failed");
+        return;
+    }
+
+    double seconds = result.Seconds / result.Iterations;
+    double megabytesPerSecond = input.Data.size() / seconds / (1024.0 * 1024.0);
+    double eventsPerSecond = result.Events / seconds;
+    double nanosecondsPerEvent = result.Events ? seconds * 1e9 / result.Events : 0.0;
+
+    std::printf("%-32s %-9s %10.1f %10.1f %12.2f %10.2f %10llu\n", input.Name.c_str(), storage, input.Data.size() / 1024.0,
+        megabytesPerSecond, eventsPerSecond / 1e6, nanosecondsPerEvent, (unsigned long long)result.Allocations);
+}
+
+static std::vector<BenchmarkInput> LoadAssets(const std::string& directory) {
+    std::vector<BenchmarkInput> inputs;
+
+    std::error_code error;
+    for (auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".mid")
+            continue;
+
+        std::ifstream file(entry.path(), std::ios_base::binary);
+        BenchmarkInput input;
+        input.Name = entry.path().filename().string();
+        input.Data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        inputs.push_back(std::move(input));
+    }
+
+    std::sort(inputs.begin(), inputs.end(), [](const BenchmarkInput& a, const BenchmarkInput& b) { return a.Name < b.Name; });
+    return inputs;
+}
+
+// Usage: Benchmark [assets directory] [seconds per case]
+int main(int argc, char** argv) {
+    std::string assets = argc > 1 ? argv[1] : MIDI_ASSETS_DIR;
+    double minimumSeconds = argc > 2 ? std::atof(argv[2]) : 0.2;
+
+    std::vector<BenchmarkInput> inputs = LoadAssets(assets);
+    if (inputs.empty())
+        std::cout << "No MIDI files found in " << assets << "\n";
+
+    for (const SyntheticMidiDescription& description : GetSyntheticCorpus())
+        inputs.push_back({ "synthetic: " + description.Name, GenerateSyntheticMidi(description) });
+
+    ParseOptions events;
+    ParseOptions compact;
+    compact.Storage = TrackStorage::Compact;
+
+    PrintHeader();
+    for (const BenchmarkInput& input : inputs) {
+        PrintResult(input, "events", Run(input, events, minimumSeconds));
+        PrintResult(input, "compact", Run(input, compact, minimumSeconds));
+    }
+
+    RunKernelBenchmarks(minimumSeconds);
+
+    std::printf("\nPeak resident memory: %.1f MB\n", PeakResidentBytes() / (1024.0 * 1024.0));
+}
@@ -0,0 +1,178 @@
+#include "SyntheticMidi.h"
+
+// Small deterministic generator so the corpus is identical on every platform
+class Random {
+public:
+    Random(uint32_t seed) : m_State(seed ? seed : 1) {}
+
+    inline uint32_t Next() {
+        m_State ^= m_State << 13;
+        m_State ^= m_State >> 17;
+        m_State ^= m_State << 5;
+        return m_State;
+    }
+
+    inline uint32_t Range(uint32_t count) { return Next() % count; }
+    inline bool Chance(float ratio) { return (Next() & 0xffffff) < (uint32_t)(ratio * 0x1000000); }
+private:
+    uint32_t m_State;
+};
+
+static void WriteInteger(std::vector<uint8_t>& output, uint32_t number) {
+    output.push_back((uint8_t)(number >> 24));
+    output.push_back((uint8_t)(number >> 16));
+    output.push_back((uint8_t)(number >> 8));
+    output.push_back((uint8_t)number);
+}
+
+static void WriteShort(std::vector<uint8_t>& output, uint16_t number) {
+    output.push_back((uint8_t)(number >> 8));
+    output.push_back((uint8_t)number);
+}
+
+static void WriteVariableLengthValue(std::vector<uint8_t>& output, uint32_t value) {
+    uint8_t bytes[4];
+    int count = 0;
+
+    do {
+        bytes[count++] = value & 0x7f;
+        value >>= 7;
+    } while (value && count < 4);
+
+    while (count-- > 1)
+        output.push_back(bytes[count] | 0x80);
+    output.push_back(bytes[0]);
+}
+
+static void WriteTrack(std::vector<uint8_t>& output, const SyntheticMidiDescription& description, Random& random, uint16_t trackIndex) {
+    output.insert(output.end(), { 'M', 'T', 'r', 'k' });
+    size_t sizePosition = output.size();
+    WriteInteger(output, 0);  // Filled in once the track is written
+
+    uint8_t channel = trackIndex % 16;
+    uint8_t runningStatus = 0;
+
+    if (trackIndex == 0) {  // Tempo of 100 bpm
+        output.insert(output.end(), { 0x00, 0xff, 0x51, 0x03, 0x09, 0x27, 0xc0 });
+    }
+
+    for (uint32_t i = 0; i < description.EventsPerTrack; i++) {
+        // Mostly short delta times with the occasional long one, like real music
+        uint32_t deltaTime = random.Chance(0.1f) ? random.Range(20000) : random.Range(120);
+        WriteVariableLengthValue(output, deltaTime);
+
+        if (random.Chance(description.MetaRatio)) {
+            output.push_back(0xff);
+            output.push_back(0x01);  // Text
+            WriteVariableLengthValue(output, description.MetaSize);
+            for (uint32_t j = 0; j < description.MetaSize; j++)
+                output.push_back((uint8_t)('a' + random.Range(26)));
+            runningStatus = 0;
+            continue;
+        }
+
+        if (random.Chance(description.SysExRatio)) {
+            output.push_back(0xf0);
+            WriteVariableLengthValue(output, description.SysExSize);
+            for (uint32_t j = 0; j + 1 < description.SysExSize; j++)
+                output.push_back((uint8_t)random.Range(128));
+            output.push_back(0xf7);
+            runningStatus = 0;
+            continue;
+        }
+
+        uint8_t status;
+        if (runningStatus != 0 && random.Chance(description.RunningStatusRatio)) {
+            status = runningStatus;  // Running status: the status byte is left out
+        } else {
+            uint32_t kind = random.Range(16);
+            if (kind < 12)
+                status = (kind & 1 ? 0x90 : 0x80) | channel;
+            else if (kind < 14)
+                status = 0xb0 | channel;
+            else if (kind < 15)
+                status = 0xe0 | channel;
+            else
+                status = 0xc0 | channel;
+
+            output.push_back(status);
+        }
+        runningStatus = status;
+
+        output.push_back((uint8_t)random.Range(128));
+        if ((status & 0xf0) != 0xc0)
+            output.push_back((uint8_t)(1 + random.Range(127)));
+    }
+
+    output.insert(output.end(), { 0x00, 0xff, 0x2f, 0x00 });  // End of track
+
+    uint32_t size = (uint32_t)(output.size() - sizePosition - 4);
+    output[sizePosition] = (uint8_t)(size >> 24);
+    output[sizePosition + 1] = (uint8_t)(size >> 16);
+    output[sizePosition + 2] = (uint8_t)(size >> 8);
+    output[sizePosition + 3] = (uint8_t)size;
+}
+
+std::vector<uint8_t> GenerateSyntheticMidi(const SyntheticMidiDescription& description) {
+    Random random(description.Seed);
+    std::vector<uint8_t> output;
+
+    output.insert(output.end(), { 'M', 'T', 'h', 'd' });
+    WriteInteger(output, 6);
+    WriteShort(output, description.TrackCount > 1 ? 1 : 0);
+    WriteShort(output, description.TrackCount);
+    WriteShort(output, 480);
+
+    for (uint16_t i = 0; i < description.TrackCount; i++)
+        WriteTrack(output, description, random, i);
+
+    return output;
+}
+
+std::vector<SyntheticMidiDescription> GetSyntheticCorpus() {
+    std::vector<SyntheticMidiDescription> corpus;
+
+    SyntheticMidiDescription manyTracks;
+    manyTracks.Name = "many tracks";
+    manyTracks.TrackCount = 64;
+    manyTracks.EventsPerTrack = 4000;
+    manyTracks.MetaRatio = 0.01f;
+    manyTracks.Seed = 1;
+    corpus.push_back(manyTracks);
+
+    SyntheticMidiDescription runningStatus;
+    runningStatus.Name = "running status";
+    runningStatus.TrackCount = 4;
+    runningStatus.EventsPerTrack = 50000;
+    runningStatus.RunningStatusRatio = 0.9f;
+    runningStatus.Seed = 2;
+    corpus.push_back(runningStatus);
+
+    SyntheticMidiDescription bigMeta;
+    bigMeta.Name = "large meta";
+    bigMeta.TrackCount = 4;
+    bigMeta.EventsPerTrack = 20000;
+    bigMeta.MetaRatio = 0.3f;
+    bigMeta.MetaSize = 512;
+    bigMeta.Seed = 3;
+    corpus.push_back(bigMeta);
+
+    SyntheticMidiDescription bigSysEx;
+    bigSysEx.Name = "large sysex";
+    bigSysEx.TrackCount = 2;
+    bigSysEx.EventsPerTrack = 5000;
+    bigSysEx.SysExRatio = 0.05f;
+    bigSysEx.SysExSize = 8192;
+    bigSysEx.Seed = 4;
+    corpus.push_back(bigSysEx);
+
+    SyntheticMidiDescription hugeTrack;
+    hugeTrack.Name = "huge track";
+    hugeTrack.TrackCount = 1;
+    hugeTrack.EventsPerTrack = 2000000;
+    hugeTrack.RunningStatusRatio = 0.5f;
+    hugeTrack.Seed = 5;
+    corpus.push_back(hugeTrack);
+
+    return corpus;
+}
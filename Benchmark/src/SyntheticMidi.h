@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Describes a generated MIDI file. The same description always produces the same bytes.
+struct SyntheticMidiDescription {
+    std::string Name;
+
+    uint16_t TrackCount = 1;
+    uint32_t EventsPerTrack = 1000;
+
+    float RunningStatusRatio = 0.0f;  // Fraction of channel events written without a status byte
+    float MetaRatio = 0.0f;  // Fraction of events that are text meta events
+    uint32_t MetaSize = 16;  // Size of each text meta event
+    float SysExRatio = 0.0f;  // Fraction of events that are SysEx messages
+    uint32_t SysExSize = 64;
+
+    uint32_t Seed = 1;
+};
+
+std::vector<uint8_t> GenerateSyntheticMidi(const SyntheticMidiDescription& description);
+
+// The corpus the benchmark runs against
+std::vector<SyntheticMidiDescription> GetSyntheticCorpus();
@@ -64,4 +64,13 @@ int main() {
     std::cout << "MIDI duration: " << minutes << " minutes and " << seconds << " seconds\n";
 
     std::cout << s_AllocCount << " allocations\n";
+
+    // Only filled when the library is built with MIDI_PARSER_STATS
+    if (ParseStats::Enabled) {
+        const ParseStats& stats = reader->GetStats();
+        std::cout << stats.GetEventCount() << " events (" << stats.RunningStatusEvents << " with running status), "
+            << stats.Allocations << " parser allocations (" << stats.TrackGrowths << " growths)\n";
+        std::cout << "Last parse: " << stats.OpenTime << " ns, of which " << stats.ScanChunksTime << " scanning chunks, "
+            << stats.ReadTracksTime << " reading tracks and " << stats.TempoMapTime << " building the tempo map\n";
+    }
 }
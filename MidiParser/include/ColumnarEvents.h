@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CompactTrack.h"
+#include "MidiEvent.h"
+#include "MidiTrack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MidiParser;
+
+// Channel events as parallel arrays, so a column can be scanned (or vectorised) on its own
+struct ColumnarEvents {
+    std::vector<uint32_t> Tick;
+    std::vector<uint16_t> Track;
+    std::vector<uint8_t> Channel;
+    std::vector<MidiEventType> Type;  // Without the channel bits; NoteOn with velocity 0 is NoteOff
+    std::vector<uint8_t> DataA;  // Note, controller, program...
+    std::vector<uint8_t> DataB;  // Velocity, value... 0 for events with one data byte
+
+    inline size_t GetSize() const { return Tick.size(); }
+
+    void Reserve(size_t count);
+    void Clear();  // Keeps the capacity
+};
+
+// Notes built from matching NoteOn and NoteOff events
+struct ColumnarNotes {
+    std::vector<uint32_t> Start;  // Tick of the NoteOn
+    std::vector<uint32_t> Duration;  // In ticks
+    std::vector<uint16_t> Track;
+    std::vector<uint8_t> Channel;
+    std::vector<uint8_t> Pitch;
+    std::vector<uint8_t> Velocity;
+
+    inline size_t GetSize() const { return Start.size(); }
+
+    void Reserve(size_t count);
+    void Clear();
+};
+
+// Builds the columns in one pass over the events. The arrays are reused
+// from one export to the next, so repeated exports stop allocating.
+class ColumnarExporter {
+public:
+    ColumnarExporter(bool pairNotes = false) : m_PairNotes(pairNotes) {}
+
+    // Each export replaces the previous one
+    void Export(const MidiTrack& track, uint16_t trackIndex = 0);
+    void Export(const CompactTrack& track, uint16_t trackIndex = 0);
+    void Export(const MidiParser& parser);  // Every track, merged in tick order
+
+    inline const ColumnarEvents& GetEvents() const { return m_Events; }
+    inline const ColumnarNotes& GetNotes() const { return m_Notes; }  // Empty unless pairNotes was set
+private:
+    void Begin(size_t trackCount, size_t eventCount);
+    inline void Append(uint32_t tick, uint16_t track, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB);
+    void End(uint32_t endTick);  // Notes still sounding last until endTick
+
+    inline size_t KeyOf(uint16_t track, uint8_t channel, uint8_t pitch) const;
+private:
+    bool m_PairNotes;
+    bool m_Merged = false;  // Keys are kept per track
+
+    ColumnarEvents m_Events;
+    ColumnarNotes m_Notes;
+
+    // Notes sounding on each (track, channel, pitch), oldest first, so
+    // repeated NoteOns on one key are ended by NoteOffs in the same order.
+    std::vector<int32_t> m_FirstSounding;  // -1 if none
+    std::vector<int32_t> m_LastSounding;
+    std::vector<int32_t> m_NextSounding;  // Per note
+};
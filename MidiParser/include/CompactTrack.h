@@ -0,0 +1,124 @@
+#pragma once
+
+#include "MidiEvent.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One event in a CompactTrack. Channel events are stored inline; meta
+// payloads (and their meta type) live out of line in the track.
+struct CompactEvent {
+    // The payload index is 24 bits, so a track holds at most this many meta and
+    // SysEx events. A track with more fails with MidiErrorCode::TooManyPayloads.
+    static constexpr uint32_t MaxPayloads = 1 << 24;
+
+    uint32_t Tick;
+    EventCategory Category;
+    uint8_t Data[3];  // Midi: status byte, data A, data B. Otherwise: 24 bit payload index
+
+    inline bool IsMidi() const { return Category == EventCategory::Midi; }
+
+    inline MidiEventType GetMidiType() const { return (MidiEventType)(Data[0] & 0xf0); }
+    inline uint8_t GetChannel() const { return Data[0] & 0x0f; }
+    inline uint8_t GetDataA() const { return Data[1]; }
+    inline uint8_t GetDataB() const { return Data[2]; }
+
+    inline uint32_t GetPayloadIndex() const { return Data[0] | Data[1] << 8 | Data[2] << 16; }
+};
+
+static_assert(sizeof(CompactEvent) == 8, "CompactEvent must stay packed");
+
+// Out of line description of a meta event's or SysEx packet's data
+struct CompactPayload {
+    uint32_t Offset;  // Meta: offset into the track's payload bytes. SysEx: offset into the source
+    uint32_t Size;
+    uint8_t Type;  // MetaEventType or SysExPacket
+};
+
+// What a visitor receives for a meta event
+struct CompactMetaEvent {
+    uint32_t Tick;
+    MetaEventType Type;
+    const uint8_t* Data;
+    uint32_t Size;
+};
+
+// What a visitor receives for a SysEx packet; Data points into the parsed file
+struct CompactSysExEvent {
+    uint32_t Tick;
+    EventCategory Category;  // SysEx (F0) or EndSysEx (F7)
+    SysExPacket Packet;
+    const uint8_t* Data;
+    uint32_t Size;
+};
+
+// Non-virtual track storage: contiguous 8 byte records instead of polymorphic events
+class CompactTrack {
+public:
+    CompactTrack() = default;
+
+    inline uint32_t TotalTicks() const { return m_TotalTicks; }
+    inline size_t GetEventCount() const { return m_Events.size(); }
+    inline size_t GetPayloadCount() const { return m_Payloads.size(); }  // Meta and SysEx events
+    inline size_t GetSizeBytes() const {
+        return m_Events.size() * sizeof(CompactEvent) + m_Payloads.size() * sizeof(CompactPayload) + m_PayloadData.size();
+    }
+
+    const CompactEvent& operator[](size_t index) const { return m_Events[index]; }
+
+    const CompactEvent* begin() const { return m_Events.data(); }
+    const CompactEvent* end() const { return m_Events.data() + m_Events.size(); }
+
+    inline CompactMetaEvent GetMetaEvent(const CompactEvent& event) const {
+        const CompactPayload& payload = m_Payloads[event.GetPayloadIndex()];
+        return { event.Tick, (MetaEventType)payload.Type, m_PayloadData.data() + payload.Offset, payload.Size };
+    }
+
+    // SysEx data is not copied; it points into the parsed file or buffer
+    inline CompactSysExEvent GetSysExEvent(const CompactEvent& event) const {
+        const CompactPayload& payload = m_Payloads[event.GetPayloadIndex()];
+        return { event.Tick, event.Category, (SysExPacket)payload.Type, m_SourceData + payload.Offset, payload.Size };
+    }
+
+    // Calls visitor(const CompactEvent&) for channel events, visitor(const CompactMetaEvent&)
+    // for meta events and visitor(const CompactSysExEvent&) for SysEx packets, in order
+    template<typename Visitor>
+    void Visit(Visitor&& visitor) const {
+        for (const CompactEvent& event : m_Events) {
+            switch (event.Category) {
+                case EventCategory::Midi:
+                    visitor(event);
+                    break;
+                case EventCategory::Meta:
+                    visitor(GetMetaEvent(event));
+                    break;
+                case EventCategory::SysEx:
+                case EventCategory::EndSysEx:
+                    visitor(GetSysExEvent(event));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+private:
+    void Reserve(size_t eventCount, size_t payloadCount, size_t payloadBytes);
+    void Clear();  // Drops every event but keeps the buffers
+
+    void AppendMidiEvent(uint32_t tick, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB);
+    void AppendMetaEvent(uint32_t tick, MetaEventType type, const uint8_t* data, uint32_t size);
+    void AppendSysExEvent(uint32_t tick, EventCategory category, SysExPacket packet, const uint8_t* data, uint32_t size);
+private:
+    friend class MidiCache;
+    template<typename Track> friend struct FilterSink;
+    friend class MidiParser;
+
+    std::vector<CompactEvent> m_Events;
+    std::vector<CompactPayload> m_Payloads;
+    std::vector<uint8_t> m_PayloadData;
+    const uint8_t* m_SourceData = nullptr;  // Start of the parsed file or buffer
+    std::shared_ptr<const void> m_Source;  // Keeps the mapped file that SysEx data points into alive
+
+    uint32_t m_TotalTicks = 0;  // Amount of ticks the track lasts for
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "MidiEvent.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MidiParser;
+
+// The controller state of one channel. Values that no event has set yet are
+// Unset, so a receiver keeps its own. Poly aftertouch belongs to the notes
+// sounding at the time, which a seek cuts off, so it is not kept.
+struct ChannelState {
+    static constexpr uint8_t Unset = 0xff;
+    static constexpr uint16_t UnsetPitchBend = 0xffff;
+
+    uint8_t Controllers[120];  // Channel mode messages (120 to 127) are applied, not stored
+    uint8_t Program;
+    uint8_t Pressure;  // Channel aftertouch
+    uint16_t PitchBend;  // 14 bits, 8192 is the centre
+
+    ChannelState() { Reset(); }
+
+    void Reset();  // Everything back to Unset
+    void Apply(MidiEventType type, uint8_t dataA, uint8_t dataB);  // Other event types are ignored
+
+    // Calls callback(MidiEventType type, uint8_t dataA, uint8_t dataB) for every
+    // value that is set: controllers by number, then program, pitch bend and pressure
+    template<typename Callback>
+    void Visit(Callback&& callback) const {
+        for (uint8_t controller = 0; controller < 120; controller++) {
+            if (Controllers[controller] != Unset)
+                callback(MidiEventType::ControlChange, controller, Controllers[controller]);
+        }
+
+        if (Program != Unset)
+            callback(MidiEventType::ProgramChange, Program, (uint8_t)0);
+        if (PitchBend != UnsetPitchBend)
+            callback(MidiEventType::PitchBend, (uint8_t)(PitchBend & 0x7f), (uint8_t)(PitchBend >> 7));
+        if (Pressure != Unset)
+            callback(MidiEventType::ChannelAfterTouch, Pressure, (uint8_t)0);
+    }
+};
+
+// The controller state of all 16 channels
+struct ControllerState {
+    ChannelState Channels[16];
+
+    inline void Reset() {
+        for (ChannelState& channel : Channels)
+            channel.Reset();
+    }
+
+    inline void Apply(MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+        Channels[channel & 0x0f].Apply(type, dataA, dataB);
+    }
+
+    // Calls callback(uint8_t channel, MidiEventType type, uint8_t dataA, uint8_t dataB)
+    // for every value that is set, channel by channel. Sending these restores the state.
+    template<typename Callback>
+    void Visit(Callback&& callback) const {
+        for (uint8_t channel = 0; channel < 16; channel++)
+            Channels[channel].Visit([&](MidiEventType type, uint8_t dataA, uint8_t dataB) { callback(channel, type, dataA, dataB); });
+    }
+};
+
+// Gives the controller state of every channel at any tick without replaying
+// the file from the start. Build copies the controller events of every track
+// (merged in tick order, like MergedEvents) into one packed list and
+// snapshots the state every eventInterval of them, and whenever tickInterval
+// ticks have passed since the last snapshot (0 turns either off). StateAt
+// starts from the nearest snapshot and replays at most eventInterval events.
+//
+// To seek a player: StateAt(tick, state), send what state.Visit gives, then
+// play from the first event at tick (MidiSequencer::Seek).
+class ControllerIndex {
+public:
+    ControllerIndex() = default;
+    ControllerIndex(const MidiParser& parser, uint32_t eventInterval = 1024, uint32_t tickInterval = 0) {
+        Build(parser, eventInterval, tickInterval);
+    }
+
+    void Build(const MidiParser& parser, uint32_t eventInterval = 1024, uint32_t tickInterval = 0);
+
+    // The state once every event before tick has been applied; events on tick are not
+    void StateAt(uint32_t tick, ControllerState& state) const;
+
+    inline size_t GetEventCount() const { return m_Events.size(); }
+    inline size_t GetCheckpointCount() const { return m_Checkpoints.size(); }
+    inline size_t GetSizeBytes() const {
+        return m_Events.size() * sizeof(Entry) + m_Checkpoints.size() * (sizeof(uint32_t) + sizeof(ControllerState));
+    }
+private:
+    struct Entry {
+        uint32_t Tick;
+        uint8_t Status;  // Type and channel
+        uint8_t DataA;
+        uint8_t DataB;
+    };
+
+    inline void AddEvent(uint32_t tick, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB);
+    void AddCheckpoints(uint32_t eventInterval, uint32_t tickInterval);
+private:
+    std::vector<Entry> m_Events;  // Controller events of every track in tick order
+    std::vector<uint32_t> m_Checkpoints;  // Index of the first event each snapshot leaves out. The first is 0.
+    std::vector<ControllerState> m_States;  // Snapshot of each checkpoint
+};
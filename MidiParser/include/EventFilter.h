@@ -0,0 +1,59 @@
+#pragma once
+
+#include "MidiEvent.h"
+
+#include <cstdint>
+
+// Chooses which events a parse stores. Rejected events are skipped without
+// being built; their delta times still count towards the ticks of the events
+// after them. Tempo events are always kept, because the tempo map and event
+// times are built from them. A NoteOn with velocity 0 is seen as a NoteOff.
+class EventFilter {
+public:
+    EventFilter() = default;  // Accepts every event
+
+    static inline EventFilter None() {  // Accepts nothing but tempo events; enable what you need
+        EventFilter filter;
+        filter.m_MidiTypes = 0;
+        filter.m_Channels = 0;
+        filter.m_MetaTypes[0] = filter.m_MetaTypes[1] = filter.m_MetaTypes[2] = filter.m_MetaTypes[3] = 0;
+        filter.m_SysEx = false;
+        return filter;
+    }
+
+    // A channel event is stored when both its type and its channel are accepted
+    inline EventFilter& SetMidi(MidiEventType type, bool accept) { Set(m_MidiTypes, MidiBit(type), accept); return *this; }
+    inline EventFilter& SetChannel(uint8_t channel, bool accept) { Set(m_Channels, 1 << (channel & 0x0f), accept); return *this; }
+    inline EventFilter& SetMeta(MetaEventType type, bool accept) { Set(m_MetaTypes[type >> 6], 1ull << (type & 63), accept); return *this; }
+    inline EventFilter& SetSysEx(bool accept) { m_SysEx = accept; return *this; }  // F0 and F7 events
+
+    inline bool AcceptsMidi(MidiEventType type, uint8_t channel) const {
+        return (m_MidiTypes & MidiBit(type)) && (m_Channels & (1 << channel));
+    }
+
+    inline bool AcceptsMeta(MetaEventType type) const {
+        return type == MetaEventType::Tempo || (m_MetaTypes[type >> 6] >> (type & 63) & 1);
+    }
+
+    inline bool AcceptsSysEx() const { return m_SysEx; }
+
+    inline bool AcceptsAll() const {
+        return m_MidiTypes == 0x7f && m_Channels == 0xffff && m_SysEx &&
+            (m_MetaTypes[0] & m_MetaTypes[1] & m_MetaTypes[2] & m_MetaTypes[3]) == ~0ull;
+    }
+private:
+    static inline uint8_t MidiBit(MidiEventType type) { return 1 << ((type >> 4) & 7); }
+
+    template<typename T, typename U>
+    static inline void Set(T& mask, U bit, bool accept) {
+        if (accept)
+            mask |= (T)bit;
+        else
+            mask &= (T)~(T)bit;
+    }
+private:
+    uint8_t m_MidiTypes = 0x7f;  // Bit (type >> 4) & 7 of each accepted MidiEventType
+    uint16_t m_Channels = 0xffff;
+    uint64_t m_MetaTypes[4] = { ~0ull, ~0ull, ~0ull, ~0ull };
+    bool m_SysEx = true;
+};
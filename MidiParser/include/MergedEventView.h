@@ -0,0 +1,123 @@
+#pragma once
+
+#include "CompactTrack.h"
+#include "MidiTrack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Walks the events of several tracks in global tick order without copying
+// them. Events on the same tick come out in track order, then file order.
+template<typename TrackType>
+class MergedEventView {
+public:
+    struct Position {
+        uint32_t Tick;
+        uint16_t Track;
+        uint32_t Index;  // Index of the event in its track
+    };
+public:
+    MergedEventView() = default;
+    MergedEventView(const std::vector<TrackType>& tracks) : m_Tracks(&tracks) {
+        m_Positions.resize(tracks.size(), 0);
+        m_Heap.reserve(tracks.size());
+        Seek(0);
+    }
+
+    inline bool IsEnd() const { return m_Heap.empty(); }
+
+    // Only valid while !IsEnd()
+    inline Position Current() const {
+        uint16_t track = m_Heap.front();
+        return { TickOf(track, m_Positions[track]), track, m_Positions[track] };
+    }
+
+    inline uint32_t CurrentTick() const { return TickOf(m_Heap.front(), m_Positions[m_Heap.front()]); }
+    inline uint16_t CurrentTrack() const { return m_Heap.front(); }
+
+    // Event* for MidiTrack, const CompactEvent& for CompactTrack
+    inline decltype(auto) CurrentEvent() const {
+        uint16_t track = m_Heap.front();
+        return (*m_Tracks)[track][m_Positions[track]];
+    }
+
+    void Advance() {
+        uint16_t track = m_Heap.front();
+
+        if (++m_Positions[track] < (*m_Tracks)[track].GetEventCount()) {
+            SiftDown(0);  // The track stays in the heap with its next event
+        } else {
+            m_Heap.front() = m_Heap.back();
+            m_Heap.pop_back();
+            if (!m_Heap.empty())
+                SiftDown(0);
+        }
+    }
+
+    // Moves to the first event at or after tick. Each track is binary searched.
+    void Seek(uint32_t tick) {
+        m_Heap.clear();
+
+        for (size_t i = 0; i < m_Tracks->size(); i++) {
+            const TrackType& track = (*m_Tracks)[i];
+
+            size_t low = 0, high = track.GetEventCount();
+            while (low < high) {
+                size_t middle = low + (high - low) / 2;
+                if (TickOf((uint16_t)i, (uint32_t)middle) < tick)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+
+            m_Positions[i] = (uint32_t)low;
+            if (low < track.GetEventCount())
+                m_Heap.push_back((uint16_t)i);
+        }
+
+        for (size_t i = m_Heap.size() / 2; i-- > 0; )
+            SiftDown(i);
+    }
+private:
+    inline uint32_t TickOf(uint16_t track, uint32_t index) const {
+        if constexpr (std::is_same_v<TrackType, CompactTrack>)
+            return (*m_Tracks)[track][index].Tick;
+        else
+            return (*m_Tracks)[track][index]->GetTick();
+    }
+
+    inline bool Before(uint16_t a, uint16_t b) const {
+        uint32_t tickA = TickOf(a, m_Positions[a]);
+        uint32_t tickB = TickOf(b, m_Positions[b]);
+        return tickA < tickB || (tickA == tickB && a < b);
+    }
+
+    void SiftDown(size_t index) {
+        size_t count = m_Heap.size();
+        uint16_t track = m_Heap[index];
+
+        for (;;) {
+            size_t child = index * 2 + 1;
+            if (child >= count)
+                break;
+            if (child + 1 < count && Before(m_Heap[child + 1], m_Heap[child]))
+                child++;
+            if (!Before(m_Heap[child], track))
+                break;
+
+            m_Heap[index] = m_Heap[child];
+            index = child;
+        }
+
+        m_Heap[index] = track;
+    }
+private:
+    const std::vector<TrackType>* m_Tracks = nullptr;
+    std::vector<uint32_t> m_Positions;  // Next event of each track
+    std::vector<uint16_t> m_Heap;  // Tracks with events left, ordered by (tick, track)
+};
+
+using MergedEvents = MergedEventView<MidiTrack>;
+using MergedCompactEvents = MergedEventView<CompactTrack>;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MidiParser.h"
+
+class ThreadPool;
+
+// A file already in memory
+struct MidiBuffer {
+    const uint8_t* Data;
+    size_t Size;
+};
+
+struct MidiBatchResult {
+    bool Success = false;
+    MidiError Error;
+    std::unique_ptr<MidiParser> Parser;  // Only set by ParseAll when the file parsed
+};
+
+// Parses many files at once, one file per task, on a work-stealing thread pool
+class MidiBatchParser {
+public:
+    // index is the position of the file in the input. parser belongs to the
+    // worker and is reused for its next file, so it is only valid during the call.
+    using Callback = std::function<void(size_t index, MidiParser& parser, bool success)>;
+public:
+    MidiBatchParser(const ParseOptions& options = ParseOptions(), unsigned threads = 0);  // 0 uses every core
+    MidiBatchParser(const MidiBatchParser& other) = delete;
+
+    ~MidiBatchParser();
+
+    MidiBatchParser& operator=(const MidiBatchParser& other) = delete;
+
+    unsigned GetThreadCount() const;
+
+    // Streams results through the callback; steady state parsing reuses each worker's buffers
+    void ForEach(const std::vector<std::string>& files, const Callback& callback);
+    void ForEach(const std::vector<MidiBuffer>& buffers, const Callback& callback);
+
+    // Keeps every parsed file. Results are in input order.
+    std::vector<MidiBatchResult> ParseAll(const std::vector<std::string>& files);
+    std::vector<MidiBatchResult> ParseAll(const std::vector<MidiBuffer>& buffers);
+private:
+    template<typename Input>
+    void Run(const std::vector<Input>& inputs, const Callback& callback);
+    template<typename Input>
+    std::vector<MidiBatchResult> RunAll(const std::vector<Input>& inputs);
+private:
+    ParseOptions m_Options;
+    std::unique_ptr<ThreadPool> m_ThreadPool;
+    std::vector<MidiParser> m_Workers;  // One parser per worker thread
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class MidiParser;
+
+// Stores parsed files on disk so they can be reopened without parsing. A
+// cache file holds the decoded CompactTrack arrays, the tempo map and the
+// chunk index. Loading maps it and copies whole arrays into the parser's
+// tracks, so there is no per-event work for TrackStorage::Compact. A cache
+// is only used while the source file has the size, modification time and
+// (unless disabled) hash it was written for.
+class MidiCache {
+public:
+    MidiCache() = default;
+
+    // Size and modification time are always compared; the hash reads the whole source
+    inline void SetHashCheck(bool hashCheck) { m_HashCheck = hashCheck; }
+
+    // Loads the cache if it is up to date, otherwise parses file and rewrites the cache
+    bool Open(MidiParser& parser, const std::string& file, const std::string& cacheFile) const;
+
+    bool Load(MidiParser& parser, const std::string& file, const std::string& cacheFile) const;  // False if missing or stale
+    bool Save(const MidiParser& parser, const std::string& file, const std::string& cacheFile) const;  // parser must have opened file
+private:
+    bool m_HashCheck = true;
+};
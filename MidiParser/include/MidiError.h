@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+enum class MidiErrorCode : uint8_t {
+    None,
+
+    // File
+    CouldNotOpenFile,
+    FileTooSmall,
+
+    // Header
+    InvalidHeaderChunk,  // Expected "MThd"
+    InvalidHeaderSize,
+    InvalidFormat,
+    InvalidDivision,
+    UnsupportedDivision,  // SMPTE time division
+    UnsupportedFormat,  // Format 2
+
+    // Chunks
+    MissingTrackChunk,  // The file ended before every "MTrk" chunk was found
+    InvalidTrackSize,  // The chunk is larger than the rest of the file
+
+    // Events
+    InvalidVariableLength,  // More than 4 bytes
+    EventOutOfBounds,  // The event runs past the end of its track chunk
+    PayloadOutOfBounds,  // A meta or SysEx length runs past the end of its track chunk
+    MissingRunningStatus,  // Data byte without a previous status byte
+    UnrecognizedEvent,
+    TooManyPayloads,  // A compact track has more meta and SysEx events than its payload index can address
+
+    // Streaming
+    EventTooLarge  // A streamed event does not fit in MidiStreamParser's buffer limit
+};
+
+struct MidiError {
+    MidiErrorCode Code = MidiErrorCode::None;
+    size_t Offset = 0;  // Offset in the file where the problem was found
+    int32_t Track = -1;  // Index of the track, -1 for the file and header
+    uint8_t Status = 0;  // Status byte of the failing event, if there is one
+
+    inline explicit operator bool() const { return Code != MidiErrorCode::None; }
+};
+
+// Called for every error as it is found, including tracks skipped in lenient mode
+using MidiErrorCallback = std::function<void(const MidiError& error)>;
+
+const char* MidiErrorToString(MidiErrorCode code);  // Static description of the error
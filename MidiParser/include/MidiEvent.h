@@ -1,13 +1,14 @@
 #pragma once
 
-#include <algorithm>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
 
 enum class EventCategory : uint8_t {
     Midi,
     Meta = 0xff,
     SysEx = 0xf0,
-    EndSysEx = 0xf7
+    EndSysEx = 0xf7,
+    System = 0xf8  // System common and real-time messages, which only come from live input (MidiWireDecoder)
 };
 
 enum MetaEventType : uint8_t {
@@ -42,8 +43,31 @@ enum MidiEventType : uint8_t {
     PitchBend = 0xe0
 };
 
+enum class SysExPacket : uint8_t {
+    Complete,  // F0 message that ends with F7
+    First,  // F0 message that is continued by F7 packets
+    Continuation,  // F7 packet in the middle of a split message
+    Last,  // F7 packet that ends a split message
+    Escape  // F7 packet with arbitrary bytes outside of a SysEx message
+};
+
+enum class SystemMessage : uint8_t {
+    TimeCode = 0xf1,  // MIDI time code quarter frame
+    SongPosition = 0xf2,
+    SongSelect = 0xf3,
+    TuneRequest = 0xf6,
+    Clock = 0xf8,
+    Start = 0xfa,
+    Continue = 0xfb,
+    Stop = 0xfc,
+    ActiveSensing = 0xfe,
+    Reset = 0xff
+};
+
 class Event {
 public:
+    friend class MidiParser;
+
     Event(uint32_t tick, float time) : m_Tick(tick), m_Time(time) {}
     virtual ~Event() {}
 
@@ -51,7 +75,7 @@ public:
     virtual inline EventCategory GetCategory() const = 0;
 
     inline uint32_t GetTick() const { return m_Tick; }
-    inline float GetTime() const { return m_Time; }
+    inline float GetTime() const { return m_Time; }  // Absolute time in microseconds
 protected:
     uint32_t m_Tick;
     float m_Time;
@@ -61,56 +85,23 @@ class MetaEvent : public Event {
 public:
     friend class MidiParser;
 
-    MetaEvent(uint32_t tick, float time, MetaEventType metaType, std::vector<uint8_t>&& data)
-        : Event(tick, time), m_MetaType(metaType), m_Data(std::move(data)) {}
-
-    MetaEvent(const MetaEvent& other)
-        : Event(other.m_Tick, other.m_Time), m_MetaType(other.m_MetaType), m_Data(other.m_Data) {}
-
-    MetaEvent(MetaEvent&& other) noexcept
-        : Event(other.m_Tick, other.m_Time), m_MetaType(other.m_MetaType), m_Data(std::move(other.m_Data)) {
-
-        other.m_Tick = 0;
-        other.m_Time = 0;
-    }
+    // data is not copied; it is owned by the track's payload arena
+    MetaEvent(uint32_t tick, float time, MetaEventType metaType, const uint8_t* data, uint32_t size)
+        : Event(tick, time), m_MetaType(metaType), m_Size(size), m_Data(data) {}
 
     virtual ~MetaEvent() override = default;
 
-    MetaEvent& operator=(const MetaEvent& other) {
-        if (&other != this) {
-            m_Tick = other.m_Tick;
-            m_Time = other.m_Time;
-            m_MetaType = other.m_MetaType;
-            m_Data = other.m_Data;
-        }
-
-        return *this;
-    }
-
-    MetaEvent& operator=(MetaEvent&& other) noexcept {
-        if (&other != this) {
-            m_Tick = other.m_Tick;
-            m_Time = other.m_Time;
-            m_MetaType = other.m_MetaType;
-            m_Data = std::move(other.m_Data);
-
-            other.m_Tick = 0;
-            other.m_Time = 0;
-        }
-
-        return *this;
-    }
-
     inline uint8_t GetType() const override { return m_MetaType; }
     inline EventCategory GetCategory() const override { return EventCategory::Meta; }
 
-    inline size_t GetSize() const { return m_Data.size(); }
-    inline uint8_t* Data() const { return (uint8_t*)m_Data.data(); }
+    inline size_t GetSize() const { return m_Size; }
+    inline const uint8_t* Data() const { return m_Data; }
 
-    uint8_t operator[](size_t index) { return m_Data[index]; }
+    uint8_t operator[](size_t index) const { return m_Data[index]; }
 protected:
     MetaEventType m_MetaType;
-    std::vector<uint8_t> m_Data;
+    uint32_t m_Size;
+    const uint8_t* m_Data;
 };
 
 class MidiEvent : public Event {
@@ -132,3 +123,27 @@ protected:
     uint8_t m_DataA;
     uint8_t m_DataB;
 };
+
+class SysExEvent : public Event {
+public:
+    friend class MidiParser;
+
+    // data is not copied; it points into the parsed file or buffer
+    SysExEvent(uint32_t tick, float time, EventCategory category, SysExPacket packet, const uint8_t* data, uint32_t size)
+        : Event(tick, time), m_Category(category), m_Packet(packet), m_Size(size), m_Data(data) {}
+
+    inline uint8_t GetType() const override { return (uint8_t)m_Category; }  // 0xf0 or 0xf7
+    inline EventCategory GetCategory() const override { return m_Category; }
+
+    inline SysExPacket GetPacket() const { return m_Packet; }
+
+    inline size_t GetSize() const { return m_Size; }
+    inline const uint8_t* Data() const { return m_Data; }  // Bytes after the length, including a closing F7
+
+    uint8_t operator[](size_t index) const { return m_Data[index]; }
+protected:
+    EventCategory m_Category;  // SysEx (F0) or EndSysEx (F7)
+    SysExPacket m_Packet;
+    uint32_t m_Size;
+    const uint8_t* m_Data;
+};
@@ -1,70 +1,200 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
 
+#include "CompactTrack.h"
+#include "EventFilter.h"
+#include "MergedEventView.h"
+#include "MidiError.h"
 #include "MidiTrack.h"
+#include "ParseStats.h"
 #include "Instruments.h"
+#include "TempoMap.h"
+
+class ByteReader;
+class MappedFile;
+class ThreadPool;
+
+enum class TrackStorage : uint8_t {
+    Events,  // Polymorphic MidiEvent/MetaEvent objects in MidiTrack
+    Compact  // Packed, non-virtual records in CompactTrack
+};
+
+struct ParseOptions {
+    TrackStorage Storage = TrackStorage::Events;
+    unsigned Threads = 1;  // Worker threads for format 1 files, 0 uses every core
+    bool Lenient = false;  // Skips (empties) a malformed track instead of failing the whole file
+    MidiErrorCallback OnError;  // Optional, called on the parsing thread
+
+    // Open only checks the header and indexes the track chunks. A track is decoded
+    // the first time it is accessed, and the tempo map and duration the first time
+    // they are asked for. An error in a track leaves it empty and is reported then
+    // (OnError, GetErrors and GetTrackError); it does not change what Open returned.
+    // Until everything it needs has been accessed, the parser must not be shared between threads.
+    bool Lazy = false;
+
+    EventFilter Filter;  // Events to store; the rest are skipped while parsing. Accepts every event by default.
+};
 
 class MidiParser {
 public:
     MidiParser() = default;
+    MidiParser(const ParseOptions& options) : m_Options(options) {}
     MidiParser(const std::string& file);
     MidiParser(const MidiParser& other) = default;
+    MidiParser(MidiParser&& other) = default;
+
+    MidiParser& operator=(const MidiParser& other) = default;
+    MidiParser& operator=(MidiParser&& other) = default;
 
     ~MidiParser() = default;
 
-    bool Open(const std::string& file);
+    // A failed Open leaves the parser as empty as a new one; only the errors say what happened
+    bool Open(const std::string& file);  // Memory maps the file and parses it in place
+    bool Open(const uint8_t* data, size_t size);  // Parses a buffer owned by the caller without copying it
+
+    inline const ParseOptions& GetOptions() const { return m_Options; }
+    inline void SetOptions(const ParseOptions& options) { m_Options = options; }  // Applies to the next Open
+
+    inline const MidiError& GetError() const { return m_Error; }  // Why the last Open failed
+    inline const std::vector<MidiError>& GetErrors() const { return m_Errors; }  // Every error of the last Open, in track order
+    MidiError GetTrackError(size_t index) const;  // Why the track was left empty, if it was. Decodes it in lazy mode.
+
+    // Counters and stage timings of the last Open, plus any lazy decoding since. All 0 unless ParseStats::Enabled.
+    inline const ParseStats& GetStats() const { return m_Stats; }
 
     inline uint16_t GetFormat() const { return m_Format; }
     inline uint16_t GetDivision() const { return m_Division; }
     inline uint16_t GetTrackCount() const { return m_TrackCount; }
 
-    inline uint32_t GetDurationSeconds() { return (uint32_t)(m_Duration / 1000000); }
+    inline uint64_t GetTotalTicks() const { ReadTiming(); return m_TotalTicks; }
+    inline uint64_t GetDurationMicroseconds() const { ReadTiming(); return m_Duration; }
+    inline uint32_t GetDurationSeconds() { ReadTiming(); return (uint32_t)(m_Duration / 1000000); }
     std::pair<uint32_t, uint32_t> GetDurationMinutesAndSeconds();
 
-    MidiTrack& operator[](size_t index) { return m_TrackList[index]; }
-    MidiTrack& GetTrack(size_t index) { return m_TrackList[index]; }
+    // Tick <-> microsecond conversion built from every tempo event in the file
+    inline const TempoMap& GetTempoMap() const { ReadTiming(); return m_TempoMap; }
+
+    // Text of the track's first TrackName event. Only the start of the chunk is read, so no track is decoded.
+    std::string GetTrackName(size_t index) const;
+
+    MidiTrack& operator[](size_t index) { DecodeTrack(index); return m_TrackList[index]; }
+    MidiTrack& GetTrack(size_t index) { DecodeTrack(index); return m_TrackList[index]; }
+    const std::vector<MidiTrack>& GetTracks() const { DecodeTracks(); return m_TrackList; }
 
-    std::vector<MidiTrack>::iterator begin() { return m_TrackList.begin(); }
-    std::vector<MidiTrack>::iterator end() { return m_TrackList.end(); }
+    // Only filled when the parser uses TrackStorage::Compact
+    const CompactTrack& GetCompactTrack(size_t index) const { DecodeTrack(index); return m_CompactTrackList[index]; }
+    const std::vector<CompactTrack>& GetCompactTracks() const { DecodeTracks(); return m_CompactTrackList; }
 
-    std::vector<MidiTrack>::reverse_iterator rbegin() { return m_TrackList.rbegin(); }
-    std::vector<MidiTrack>::reverse_iterator rend() { return m_TrackList.rend(); }
+    std::vector<MidiTrack>::iterator begin() { DecodeTracks(); return m_TrackList.begin(); }
+    std::vector<MidiTrack>::iterator end() { DecodeTracks(); return m_TrackList.end(); }
 
-    std::vector<MidiTrack>::const_iterator cbegin() { return m_TrackList.cbegin(); }
-    std::vector<MidiTrack>::const_iterator cend() { return m_TrackList.cend(); }
+    std::vector<MidiTrack>::reverse_iterator rbegin() { DecodeTracks(); return m_TrackList.rbegin(); }
+    std::vector<MidiTrack>::reverse_iterator rend() { DecodeTracks(); return m_TrackList.rend(); }
+
+    std::vector<MidiTrack>::const_iterator cbegin() { DecodeTracks(); return m_TrackList.cbegin(); }
+    std::vector<MidiTrack>::const_iterator cend() { DecodeTracks(); return m_TrackList.cend(); }
 private:
+    friend class MidiCache;
+    friend class MidiStreamParser;
+
     enum class MidiEventStatus : int8_t {
         Error,
         Success,
         End
     };
+
+    // Decoder state carried from one event to the next
+    struct TrackState {
+        MidiEventType RunningStatus = MidiEventType::None;
+        bool SysExPending = false;  // A SysEx message was started without its closing F7
+    };
+
+    struct TrackChunk {
+        size_t Offset;  // Offset of the first event in the file
+        uint32_t Size;
+    };
 private:
+    bool ParseBuffer(const uint8_t* data, size_t size);
+    void Reset(const uint8_t* data, size_t size);  // Forgets the previous file and its errors
+    void ClearFile();  // Forgets the file, keeping the errors
+    void RecycleTracks();  // Moves the tracks to the spare lists, keeping their buffers
+    template<typename Track>
+    void TakeTracks(std::vector<Track>& trackList, size_t count);  // Fills an empty track list, spare tracks first
     bool ReadFile();
-    bool ReadTrack();
-    MidiEventStatus ReadEvent(MidiTrack& track, MidiEventType& runningStatus);  // Reads a single event
+    bool ScanChunks(ByteReader& reader);  // Finds the offset and size of every track chunk
+
+    template<typename Track>
+    void PrepareTrack(Track& track) const;  // Gives the track a payload arena and the source
+    template<typename Track>
+    void ReadTracks(std::vector<Track>& trackList);
+    template<typename Track>
+    bool ReadTrack(Track& track, const TrackChunk& chunk, MidiError& error) const;  // Applies ParseOptions::Filter
+    template<typename Track>
+    bool ReadEvents(Track& track, const TrackChunk& chunk, MidiError& error) const;  // Reads every event in the chunk into track
+    // Checked reads test every byte against the end of the chunk. Padded reads
+    // require a whole event header (MAX_EVENT_HEADER bytes) to be left in it.
+    // Static so MidiStreamParser can decode events without a parser.
+    template<bool Checked, bool Padded, typename Track>
+    static MidiEventStatus ReadEvent(Track& track, ByteReader& reader, TrackState& state, MidiError& error);  // Reads a single event
+
+    inline unsigned ThreadCount() const;
+
+    template<typename Track>
+    void BuildTempoMap(std::vector<Track>& trackList);  // Also sets event times and the duration
+    void SetEventTimes(MidiTrack& track) const;
+
+    // Lazy mode. These are const because they only fill in what Open skipped.
+    inline void ReadTiming() const { if (!m_TimingRead) ReadTimingLazily(); }
+    inline void DecodeTrack(size_t index) const { if (m_PendingTracks != 0 && !m_TrackDecoded[index]) DecodeTrackLazily(index); }
+    inline void DecodeTracks() const { if (m_PendingTracks != 0) DecodeTracksLazily(); }
+
+    void ReadTimingLazily() const;  // Tempo changes and length of every track without storing events
+    void DecodeTrackLazily(size_t index) const;
+    void DecodeTracksLazily() const;
+    template<typename Track>
+    void DecodeTrackLazily(std::vector<Track>& trackList, size_t index) const;
+
+    void Report(const MidiError& error) const;  // Records the error without failing the parse
+    void Error(const MidiError& error) const;
+private:
+    std::shared_ptr<MappedFile> m_File;  // Set when the source is a mapped file
 
-    inline int32_t ReadVariableLengthValue();  // Returns -1 if invalid
-    inline uint8_t ReadByte();
-    inline uint16_t ReadShort();
-    inline uint32_t ReadInteger();
-    inline void ReadBytes(uint8_t* buffer, size_t size);  // Copies memory from m_Data to buffer
+    const uint8_t* m_Data = nullptr;  // Source bytes (mapped or borrowed)
+    size_t m_Size = 0;
 
-    inline float TicksToMicroseconds(uint32_t ticks, uint32_t tempo);
+    std::vector<TrackChunk> m_Chunks;
+    std::shared_ptr<ThreadPool> m_ThreadPool;  // Created on first parallel parse
 
-    inline void Error(const std::string& msg);
-private:
-    std::vector<uint8_t> m_Data;
-    size_t m_ReadPosition = 0;
+    ParseOptions m_Options;
+
+    // Mutable members are filled in on first use in lazy mode
 
-    std::vector<MidiTrack> m_TrackList;
+    mutable std::vector<MidiTrack> m_TrackList;
+    mutable std::vector<CompactTrack> m_CompactTrackList;
+    // Cleared tracks of earlier files. Their buffers and arenas are reused, so
+    // parsing files of a similar size again does not allocate.
+    std::vector<MidiTrack> m_SpareTracks;
+    std::vector<CompactTrack> m_SpareCompactTracks;
+    mutable std::vector<MidiError> m_TrackErrors;  // Error of each track, set as it is read
+
+    mutable std::vector<bool> m_TrackDecoded;  // Only used in lazy mode
+    mutable size_t m_PendingTracks = 0;  // Tracks not decoded yet
+    mutable bool m_TimingRead = true;
+
+    mutable TempoMap m_TempoMap;
 
     uint16_t m_Format = 0, m_TrackCount = 0, m_Division = 0;
 
-    uint64_t m_TotalTicks = 0;  // Duration of MIDI file in ticks
-    uint64_t m_Duration = 0;  // Duration of MIDI file in microseconds
+    mutable uint64_t m_TotalTicks = 0;  // Duration of MIDI file in ticks
+    mutable uint64_t m_Duration = 0;  // Duration of MIDI file in microseconds
+
+    mutable bool m_ErrorStatus = true;  // True if no error
+    mutable MidiError m_Error;
+    mutable std::vector<MidiError> m_Errors;  // Only allocates once something goes wrong
 
-    bool m_ErrorStatus = true;  // True if no error
+    mutable ParseStats m_Stats;
 };
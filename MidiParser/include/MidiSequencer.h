@@ -0,0 +1,91 @@
+#pragma once
+
+#include "MergedEventView.h"
+#include "MidiEvent.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class MidiParser;
+class TempoMap;
+
+// An event scheduled for playback. Data points into the parser's tracks.
+struct SequencedEvent {
+    uint64_t Time;  // Microseconds on the caller's playback clock when the event is due
+    uint32_t Tick;
+    uint32_t Generation;  // Seek starts a new generation; Pop drops events of older ones
+    uint16_t Track;
+    EventCategory Category;
+    uint8_t Type;  // MidiEventType, MetaEventType or 0xf0/0xf7 for SysEx
+    uint8_t Channel;
+    uint8_t DataA;
+    uint8_t DataB;
+    const uint8_t* Data;  // Meta and SysEx payload
+    uint32_t Size;
+};
+
+// Walks the tracks of a parsed file in time order and queues the events that
+// are due within a look-ahead window for a playback thread. Times follow the
+// file's tempo map and a speed factor, on a microsecond clock the caller
+// passes in (so it can be an audio sample clock). The producer methods must
+// all be called from one thread; Pop and PopDue from one other thread, and
+// they never lock or allocate. The parser must outlive the sequencer.
+class MidiSequencer {
+public:
+    MidiSequencer(const MidiParser& parser, size_t queueCapacity = 1024);
+    MidiSequencer(const MidiSequencer& other) = delete;
+
+    MidiSequencer& operator=(const MidiSequencer& other) = delete;
+
+    // Producer thread
+    inline void SetLookAhead(uint64_t microseconds) { m_LookAhead = microseconds; }
+    inline uint64_t GetLookAhead() const { return m_LookAhead; }
+
+    void Start(uint64_t now);  // Plays from the current position, which is due at now
+    void Seek(uint32_t tick, uint64_t now);  // Events queued before the seek are dropped by Pop
+    void SetSpeed(double speed, uint64_t now);  // 1 plays at the file's tempo. Queued events keep their times.
+    void SetLoop(uint32_t startTick, uint32_t endTick);  // Jumps back to startTick on reaching endTick
+    void ClearLoop();
+
+    size_t Update(uint64_t now);  // Queues the events due before now + the look-ahead. Returns how many.
+
+    uint32_t GetPositionTick() const;  // Tick of the next event to queue
+    bool IsFinished() const;  // Every event has been queued and there is no loop
+
+    // Consumer thread
+    bool Pop(SequencedEvent& event);  // Next queued event, whether due or not
+    bool PopDue(SequencedEvent& event, uint64_t now);  // Next queued event if it is due by now
+private:
+    inline uint64_t OutputTime(uint32_t tick) const;  // Playback clock time of tick
+    inline void Rebase(uint64_t outputTime, uint32_t tick);  // tick plays at outputTime
+
+    inline bool IsEnd() const;
+    inline uint32_t CurrentTick() const;
+    void CurrentEvent(SequencedEvent& event) const;
+    void Advance();
+    void SeekView(uint32_t tick);
+private:
+    const MidiParser* m_Parser;
+    const TempoMap* m_TempoMap;
+    bool m_Compact;
+
+    MergedEvents m_Events;  // Used with TrackStorage::Events
+    MergedCompactEvents m_CompactEvents;  // Used with TrackStorage::Compact
+
+    uint64_t m_LookAhead = 20000;  // 20 ms
+
+    // Playback clock = m_OriginTime + (song time - m_OriginSongTime) / m_Speed
+    uint64_t m_OriginTime = 0;
+    uint64_t m_OriginSongTime = 0;
+    double m_Speed = 1.0;
+
+    bool m_Loop = false;
+    uint32_t m_LoopStart = 0, m_LoopEnd = 0;
+
+    uint32_t m_Generation = 0;  // Producer's copy
+    std::atomic<uint32_t> m_CurrentGeneration{ 0 };
+
+    SpscQueue<SequencedEvent> m_Queue;
+};
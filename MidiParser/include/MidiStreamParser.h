@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MidiError.h"
+#include "MidiEvent.h"
+
+// One decoded event. Data only points at meta and SysEx bytes and stays
+// valid until the next call to Feed or Next.
+struct StreamEvent {
+    uint16_t Track;
+    uint32_t Tick;
+    EventCategory Category;
+    uint8_t Type;  // MidiEventType, MetaEventType or SysExPacket, depending on Category
+    uint8_t Channel;
+    uint8_t DataA;
+    uint8_t DataB;
+    const uint8_t* Data;
+    uint32_t Size;
+};
+
+// Incremental SMF parser. Bytes are fed in chunks of any size and events are
+// pulled one at a time; only bytes that have not been decoded yet are kept.
+class MidiStreamParser {
+public:
+    enum class Status : uint8_t {
+        Event,  // An event was written to the output
+        TrackEnd,  // The current track chunk has ended. The output is its EndOfTrack meta event, at the track's length.
+        NeedMoreData,  // Feed more bytes and call Next again
+        End,  // Every track has been read
+        Error
+    };
+public:
+    MidiStreamParser(size_t maxBufferSize = 1 << 20);  // Largest amount of undecoded bytes kept
+    MidiStreamParser(const MidiStreamParser& other) = delete;
+
+    MidiStreamParser& operator=(const MidiStreamParser& other) = delete;
+
+    void Reset();
+
+    // Returns false if the bytes do not fit in the buffer limit; drain it with Next and feed them again.
+    // An event that can never fit makes Next fail with MidiErrorCode::EventTooLarge.
+    bool Feed(const uint8_t* data, size_t size);
+    inline void FinishInput() { m_InputFinished = true; }  // No more bytes will be fed
+
+    Status Next(StreamEvent& event);
+
+    inline const MidiError& GetError() const { return m_Error; }  // Why Next returned Error. Offset is in the file.
+
+    inline bool HasHeader() const { return m_State != State::Header; }
+    inline uint16_t GetFormat() const { return m_Format; }
+    inline uint16_t GetDivision() const { return m_Division; }
+    inline uint16_t GetTrackCount() const { return m_TrackCount; }
+
+    inline size_t GetBytesConsumed() const { return m_BytesConsumed; }  // Offset in the file of the next undecoded byte
+private:
+    enum class State : uint8_t {
+        Header,
+        ChunkHeader,
+        SkipChunk,
+        Events,
+        End,
+        Error
+    };
+
+    inline size_t Buffered() const { return m_Buffer.size() - m_BufferPosition; }
+    inline const uint8_t* BufferData() const { return m_Buffer.data() + m_BufferPosition; }
+    void Consume(size_t size);
+    Status Fail(MidiErrorCode code, uint8_t status = 0);  // Stops the stream and records the error
+
+    Status ReadHeader();
+    Status ReadChunkHeader();
+    Status ReadStreamEvent(StreamEvent& event);
+    Status EndTrack(StreamEvent& event);
+private:
+    std::vector<uint8_t> m_Buffer;
+    size_t m_BufferPosition = 0;  // Start of the undecoded bytes in m_Buffer
+    size_t m_MaxBufferSize;
+    size_t m_BytesConsumed = 0;
+    bool m_InputFinished = false;
+
+    State m_State = State::Header;
+    MidiError m_Error;
+    uint16_t m_Format = 0, m_TrackCount = 0, m_Division = 0;
+
+    uint16_t m_TrackIndex = 0;  // Number of MTrk chunks started
+    uint32_t m_ChunkRemaining = 0;  // Bytes left in the current chunk
+    uint32_t m_Tick = 0;
+    MidiEventType m_RunningStatus = MidiEventType::None;
+    bool m_SysExPending = false;
+};
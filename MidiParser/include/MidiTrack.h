@@ -2,8 +2,15 @@
 
 #include "MidiEvent.h"
 
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+class PayloadArena;
+
 class MidiTrack {
 public:
     MidiTrack() = default;
@@ -21,30 +28,47 @@ public:
     inline size_t GetSizeBytes() const { return m_PushIndex; }
 
     Event* operator[](size_t index) { return (Event*)(m_Data + m_Indicies[index]); }
+    const Event* operator[](size_t index) const { return (const Event*)(m_Data + m_Indicies[index]); }
 private:
-    void ReserveBytes(size_t sizeBytes);
-    void ReserveEvents(size_t eventCount);
+    void ReserveBytes(size_t sizeBytes);  // Keeps the buffer if it is already large enough
+    void ReserveEvents(size_t eventCount);  // Room for eventCount events of any type
+    void Reserve(size_t midiEvents, size_t metaEvents, size_t sysExEvents);  // Exactly the room these events need
+    void Clear();  // Drops every event but keeps the buffers
 
     // T is the event type
     template<typename T, typename... Args>
     T& AppendEvent(Args&&... args) {
         static_assert(std::is_base_of<Event, T>::value, "T must be an event!");
 
-        if (m_PushIndex + sizeof(T) > m_Capacity)
-            ReserveBytes(m_Capacity * 2);
+        if (m_PushIndex + sizeof(T) > m_Capacity)  // Also grows a track that was never reserved
+            ReserveBytes(std::max(m_Capacity * 2, 64 * sizeof(T)));
 
         Event* event = new(m_Data + m_PushIndex) T(std::forward<Args>(args)...);
         m_Indicies.push_back(m_PushIndex);
         m_PushIndex += sizeof(T);
         return *(T*)event;
     }
+
+    inline void AppendMidiEvent(uint32_t tick, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+        AppendEvent<MidiEvent>(tick, 0.0f, type, channel, dataA, dataB);
+    }
+
+    void AppendMetaEvent(uint32_t tick, MetaEventType type, const uint8_t* data, uint32_t size);
+
+    inline void AppendSysExEvent(uint32_t tick, EventCategory category, SysExPacket packet, const uint8_t* data, uint32_t size) {
+        AppendEvent<SysExEvent>(tick, 0.0f, category, packet, data, size);
+    }
 private:
+    friend class MidiCache;
+    template<typename Track> friend struct FilterSink;
     friend class MidiParser;
 
     uint8_t* m_Data = nullptr;
     uint32_t m_PushIndex = 0;
     size_t m_Capacity = 0;  // Size in bytes
     std::vector<uint32_t> m_Indicies;
+    std::shared_ptr<PayloadArena> m_Payloads;  // Meta event data; shared with copies of this track
+    std::shared_ptr<const void> m_Source;  // Keeps the mapped file that SysEx events point into alive
 
     uint32_t m_TotalTicks = 0;  // Amount of ticks the track lasts for
 };
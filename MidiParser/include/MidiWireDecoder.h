@@ -0,0 +1,173 @@
+#pragma once
+
+#include "MidiEvent.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// One message decoded from a live MIDI byte stream. Data only points at SysEx
+// bytes in the slice passed to Feed and is only valid during the callback.
+struct WireEvent {
+    uint64_t Time;  // Timestamp of the byte that completed the message
+    EventCategory Category;  // Midi, SysEx (first packet of a message), EndSysEx (later packets) or System
+    uint8_t Type;  // MidiEventType, SysExPacket or SystemMessage, depending on Category
+    uint8_t Channel;
+    uint8_t DataA;  // Song position: least significant 7 bits
+    uint8_t DataB;
+    const uint8_t* Data;  // SysEx bytes after F0, ending with F7 in the last packet
+    uint32_t Size;
+};
+
+// Incremental decoder for the MIDI wire protocol, as read from a device or a
+// socket. Bytes are fed in slices of any size; each message is handed to the
+// callback as soon as its last byte arrives. It follows running status, lets
+// real-time bytes (F8 to FF) interrupt any message, and passes long SysEx
+// messages on in packets that point into the slices (like the F0 and F7
+// packets of a file, see SysExPacket), so it never allocates or copies.
+// NoteOn with velocity 0 comes out as NoteOff, as in parsed files.
+class MidiWireDecoder {
+public:
+    MidiWireDecoder() = default;
+
+    // Spreads the timestamps of a slice's bytes: byte i is stamped timestamp + i * microseconds.
+    // 320 is the rate of a 5 pin DIN cable; 0 (the default) stamps a whole slice with one time.
+    inline void SetByteTime(uint32_t microseconds) { m_ByteTime = microseconds; }
+
+    inline void Reset() {
+        m_Status = 0;
+        m_Expected = 0;
+        m_Count = 0;
+        m_InSysEx = false;
+        m_SysExStarted = false;
+    }
+
+    inline size_t GetDroppedBytes() const { return m_DroppedBytes; }  // Data bytes that came without a status
+
+    // Decodes size bytes received at timestamp and calls callback(const WireEvent&) for each message
+    template<typename Callback>
+    void Feed(const uint8_t* data, size_t size, uint64_t timestamp, Callback&& callback) {
+        size_t runStart = 0;  // Start of the SysEx bytes not passed on yet
+
+        for (size_t i = 0; i < size; i++) {
+            uint8_t byte = data[i];
+
+            if (byte < 0x80) {  // Data byte
+                if (m_InSysEx)
+                    continue;  // Passed on with the rest of its run
+
+                if (m_Expected == 0) {
+                    m_DroppedBytes++;
+                    continue;
+                }
+
+                m_Data[m_Count++] = byte;
+                if (m_Count == m_Expected) {
+                    m_Count = 0;
+                    EmitMessage(timestamp + i * m_ByteTime, callback);
+                }
+                continue;
+            }
+
+            uint64_t time = timestamp + i * m_ByteTime;
+
+            if (byte >= 0xf8) {  // Real-time messages can come between any two bytes
+                if (m_InSysEx && i > runStart)
+                    EmitSysEx(data + runStart, (uint32_t)(i - runStart), false, time, callback);
+                runStart = i + 1;
+
+                if (byte != 0xf9 && byte != 0xfd)  // Undefined ones are dropped, but never kept in a message
+                    callback(WireEvent{ time, EventCategory::System, byte, 0, 0, 0, nullptr, 0 });
+                continue;
+            }
+
+            if (m_InSysEx) {  // F7 ends the message; any other status byte cuts it short
+                uint32_t length = (uint32_t)(i - runStart) + (byte == 0xf7);
+                m_InSysEx = false;
+                EmitSysEx(data + runStart, length, true, time, callback);
+
+                if (byte == 0xf7)
+                    continue;
+            }
+
+            // A status byte cancels the message it interrupts
+            m_Status = byte;
+            m_Count = 0;
+
+            if (byte < 0xf0) {
+                m_Expected = (byte & 0xe0) == 0xc0 ? 1 : 2;  // Program change and channel aftertouch have one data byte
+                continue;
+            }
+
+            // System common messages end running status
+            switch ((SystemMessage)byte) {
+                case SystemMessage::TimeCode:
+                case SystemMessage::SongSelect:
+                    m_Expected = 1;
+                    break;
+                case SystemMessage::SongPosition:
+                    m_Expected = 2;
+                    break;
+                case SystemMessage::TuneRequest:
+                    m_Status = 0;
+                    m_Expected = 0;
+                    callback(WireEvent{ time, EventCategory::System, byte, 0, 0, 0, nullptr, 0 });
+                    break;
+                default:
+                    if (byte == 0xf0) {
+                        m_InSysEx = true;
+                        m_SysExStarted = false;
+                        runStart = i + 1;
+                    }
+                    m_Status = 0;  // F0, or an undefined or stray status (F4, F5, F7)
+                    m_Expected = 0;
+                    break;
+            }
+        }
+
+        if (m_InSysEx && size > runStart)  // The message goes on in the next slice
+            EmitSysEx(data + runStart, (uint32_t)(size - runStart), false, timestamp + (size - 1) * m_ByteTime, callback);
+    }
+private:
+    template<typename Callback>
+    inline void EmitMessage(uint64_t time, Callback& callback) {
+        uint8_t dataB = m_Expected == 2 ? m_Data[1] : 0;
+
+        if (m_Status >= 0xf0) {  // System common: TimeCode, SongPosition or SongSelect
+            callback(WireEvent{ time, EventCategory::System, m_Status, 0, m_Data[0], dataB, nullptr, 0 });
+            m_Status = 0;
+            m_Expected = 0;
+            return;
+        }
+
+        MidiEventType type = (MidiEventType)(m_Status & 0xf0);
+        if (type == MidiEventType::NoteOn && dataB == 0)
+            type = MidiEventType::NoteOff;
+
+        callback(WireEvent{ time, EventCategory::Midi, type, (uint8_t)(m_Status & 0x0f), m_Data[0], dataB, nullptr, 0 });
+    }
+
+    template<typename Callback>
+    inline void EmitSysEx(const uint8_t* data, uint32_t size, bool last, uint64_t time, Callback& callback) {
+        SysExPacket packet;
+        if (last)
+            packet = m_SysExStarted ? SysExPacket::Last : SysExPacket::Complete;
+        else
+            packet = m_SysExStarted ? SysExPacket::Continuation : SysExPacket::First;
+
+        EventCategory category = m_SysExStarted ? EventCategory::EndSysEx : EventCategory::SysEx;
+        m_SysExStarted = !last;
+
+        callback(WireEvent{ time, category, (uint8_t)packet, 0, 0, 0, data, size });
+    }
+private:
+    uint8_t m_Status = 0;  // Running status, or the system common message being read. 0 if none.
+    uint8_t m_Expected = 0;  // Data bytes the status takes
+    uint8_t m_Count = 0;  // Data bytes read so far
+    uint8_t m_Data[2] = {};
+
+    bool m_InSysEx = false;
+    bool m_SysExStarted = false;  // A packet of the current message was passed on
+
+    uint32_t m_ByteTime = 0;
+    size_t m_DroppedBytes = 0;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CompactTrack.h"
+#include "MidiStreamParser.h"
+#include "MidiTrack.h"
+
+class MidiParser;
+
+// Serialises tracks to a standard MIDI file. The size of every chunk is
+// computed first, so a file is written with one allocation (or into a buffer
+// the caller provides) and, for WriteFile, one write call.
+class MidiWriter {
+public:
+    MidiWriter() = default;
+
+    // When set, repeated status bytes are left out and note offs with
+    // velocity 0 are written as note ons so they can share a running status
+    inline void SetRunningStatus(bool runningStatus) { m_RunningStatus = runningStatus; }
+
+    // A parsed file, using whichever track storage the parser was set up with
+    size_t ComputeSize(const MidiParser& parser) const;
+    size_t Write(const MidiParser& parser, uint8_t* buffer, size_t capacity) const;  // Returns the bytes written, 0 if it does not fit
+    bool Write(const MidiParser& parser, std::vector<uint8_t>& output) const;
+    bool WriteFile(const MidiParser& parser, const std::string& file) const;
+
+    // Events with their track in StreamEvent::Track, sorted by tick within each track.
+    // A track ends at its last event; keep the event MidiStreamParser gives with
+    // TrackEnd to keep the track's length.
+    // Meta and SysEx data is read through StreamEvent::Data when writing, so it has to
+    // still be valid then. MidiStreamParser reuses that memory on the next Next or
+    // Feed: to write its events later, copy each payload and point Data at the copy.
+    size_t ComputeSize(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division) const;
+    size_t Write(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division, uint8_t* buffer, size_t capacity) const;
+    bool Write(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division, std::vector<uint8_t>& output) const;
+    bool WriteFile(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division, const std::string& file) const;
+private:
+    // Sizing pass: finds the size of the file without allocating
+    template<typename Source>
+    size_t Measure(const Source& source) const;
+    template<typename Source>
+    void Encode(const Source& source, uint8_t* buffer) const;  // buffer holds at least Measure bytes
+
+    template<typename Source>
+    size_t ComputeSize(const Source& source) const;
+    template<typename Source>
+    size_t Write(const Source& source, uint8_t* buffer, size_t capacity) const;
+    template<typename Source>
+    bool Write(const Source& source, std::vector<uint8_t>& output) const;
+    template<typename Source>
+    bool WriteFile(const Source& source, const std::string& file) const;
+
+    template<typename Output, typename Track>
+    void WriteTrack(Output& output, const Track& track) const;
+private:
+    bool m_RunningStatus = true;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ColumnarEvents.h"
+#include "TempoMap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MidiParser;
+
+// Answers which notes sound at a tick (or time) or within a range of them.
+// Built once from the notes of every track, paired per track, channel and
+// pitch like ColumnarExporter does. A note sounds over [Start, Start + Duration);
+// one of zero duration counts as lasting one tick so queries still find it.
+// Queries take O(log n + k) for k results, which are indices into GetNotes()
+// in no particular order. The notes are sorted by start.
+class NoteIndex {
+public:
+    NoteIndex() = default;
+    NoteIndex(const MidiParser& parser) { Build(parser); }
+
+    void Build(const MidiParser& parser);
+
+    inline const ColumnarNotes& GetNotes() const { return m_Notes; }
+    inline size_t GetNoteCount() const { return m_Notes.GetSize(); }
+
+    // Each query appends its results to notes
+    void NotesAt(uint32_t tick, std::vector<uint32_t>& notes) const;
+    void NotesIn(uint32_t beginTick, uint32_t endTick, std::vector<uint32_t>& notes) const;  // Notes sounding at any tick of [beginTick, endTick)
+
+    // The same in microseconds, through the file's tempo map
+    void NotesAtTime(uint64_t microseconds, std::vector<uint32_t>& notes) const;
+    void NotesInTime(uint64_t beginMicroseconds, uint64_t endMicroseconds, std::vector<uint32_t>& notes) const;
+private:
+    // A centred interval tree. Each node holds the notes that contain its centre,
+    // once sorted by start and once by end; the rest go to the child on their side.
+    struct Node {
+        uint32_t Center;
+        uint32_t First;  // Range of the node's notes in m_ByStart and m_ByEnd
+        uint32_t Count;
+        int32_t Left = -1;  // Notes that end at or before the centre
+        int32_t Right = -1;  // Notes that start after it
+    };
+
+    int32_t BuildNode(std::vector<uint32_t>& notes);  // notes are sorted by start
+    inline uint32_t EndOf(uint32_t note) const;
+private:
+    ColumnarNotes m_Notes;
+    TempoMap m_TempoMap;
+
+    std::vector<Node> m_Nodes;
+    int32_t m_Root = -1;
+    std::vector<uint32_t> m_ByStart;
+    std::vector<uint32_t> m_ByEnd;  // Latest end first
+};
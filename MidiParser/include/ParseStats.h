@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+// What a parse did and where its time went. Only filled when the library is
+// built with MIDI_PARSER_STATS (the CMake option of that name); otherwise the
+// instrumentation compiles away and every field stays 0.
+struct ParseStats {
+#ifdef MIDI_PARSER_STATS
+    static constexpr bool Enabled = true;
+#else
+    static constexpr bool Enabled = false;
+#endif
+
+    uint64_t FileBytes = 0;  // Size of the parsed file
+    uint64_t TrackBytes = 0;  // Bytes of track chunks decoded
+    uint64_t Tracks = 0;  // Tracks decoded
+
+    // Events read from the file, including ones a filter dropped. Lazily reading
+    // the timing and later decoding a track counts the track's events twice.
+    uint64_t MidiEvents = 0;
+    uint64_t MetaEvents = 0;  // End of track events included
+    uint64_t SysExEvents = 0;
+    uint64_t RunningStatusEvents = 0;  // Channel events without their own status byte
+    uint64_t FilteredEvents = 0;  // Dropped by ParseOptions::Filter
+
+    uint64_t Allocations = 0;  // Track, index and payload buffers allocated
+    uint64_t TrackGrowths = 0;  // Allocations that replaced a buffer that was too small
+
+    // Nanoseconds per stage. Tracks read in parallel add up in ReadTrackTime,
+    // which can then exceed ReadTracksTime.
+    uint64_t OpenTime = 0;  // Whole call, including mapping the file
+    uint64_t ReadFileTime = 0;
+    uint64_t ScanChunksTime = 0;
+    uint64_t ReadTracksTime = 0;
+    uint64_t ReadTrackTime = 0;
+    uint64_t CountTime = 0;  // Part of ReadTrackTime spent counting events to size the tracks
+    uint64_t TempoMapTime = 0;  // Tempo map and event times
+
+    inline uint64_t GetEventCount() const { return MidiEvents + MetaEvents + SysExEvents; }
+
+    ParseStats& operator+=(const ParseStats& other) {
+        FileBytes += other.FileBytes;
+        TrackBytes += other.TrackBytes;
+        Tracks += other.Tracks;
+        MidiEvents += other.MidiEvents;
+        MetaEvents += other.MetaEvents;
+        SysExEvents += other.SysExEvents;
+        RunningStatusEvents += other.RunningStatusEvents;
+        FilteredEvents += other.FilteredEvents;
+        Allocations += other.Allocations;
+        TrackGrowths += other.TrackGrowths;
+        OpenTime += other.OpenTime;
+        ReadFileTime += other.ReadFileTime;
+        ScanChunksTime += other.ScanChunksTime;
+        ReadTracksTime += other.ReadTracksTime;
+        ReadTrackTime += other.ReadTrackTime;
+        CountTime += other.CountTime;
+        TempoMapTime += other.TempoMapTime;
+        return *this;
+    }
+};
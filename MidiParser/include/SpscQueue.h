@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Fixed size single producer, single consumer queue. Push and Pop never lock
+// or allocate; one thread may push while another pops.
+template<typename T>
+class SpscQueue {
+public:
+    SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity + 1)  // One slot stays empty to tell full from empty
+            size *= 2;
+
+        m_Items = std::make_unique<T[]>(size);
+        m_Mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue& other) = delete;
+    SpscQueue& operator=(const SpscQueue& other) = delete;
+
+    inline size_t GetCapacity() const { return m_Mask; }
+
+    // Producer thread. Returns false if the queue is full.
+    bool Push(const T& item) {
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) & m_Mask;
+
+        if (next == m_HeadCache) {
+            m_HeadCache = m_Head.load(std::memory_order_acquire);
+            if (next == m_HeadCache)
+                return false;
+        }
+
+        m_Items[tail] = item;
+        m_Tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread. The front item, or nullptr if the queue is empty; valid until the next Pop.
+    const T* Front() {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+
+        if (head == m_TailCache) {
+            m_TailCache = m_Tail.load(std::memory_order_acquire);
+            if (head == m_TailCache)
+                return nullptr;
+        }
+
+        return &m_Items[head];
+    }
+
+    // Consumer thread. Returns false if the queue is empty.
+    bool Pop(T& item) {
+        const T* front = Front();
+        if (front == nullptr)
+            return false;
+
+        item = *front;
+        Pop();
+        return true;
+    }
+
+    // Consumer thread. Drops the front item, which Front must have returned.
+    void Pop() {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+        m_Head.store((head + 1) & m_Mask, std::memory_order_release);
+    }
+private:
+    std::unique_ptr<T[]> m_Items;
+    size_t m_Mask = 0;
+
+    // Each side caches the other's index so most calls touch only their own cache line
+    alignas(64) std::atomic<size_t> m_Head{ 0 };  // Written by the consumer
+    size_t m_TailCache = 0;  // Consumer's view of m_Tail
+
+    alignas(64) std::atomic<size_t> m_Tail{ 0 };  // Written by the producer
+    size_t m_HeadCache = 0;  // Producer's view of m_Head
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct TempoChange {
+    uint32_t Tick;
+    uint32_t Tempo;  // Microseconds per quarter note
+    uint64_t Microseconds;  // Absolute time of Tick
+};
+
+// Piecewise linear mapping between ticks and microseconds, built from every
+// tempo event in the file. Lookups are a binary search over the tempo changes.
+class TempoMap {
+public:
+    TempoMap() = default;
+
+    void Clear();
+    inline std::vector<TempoChange> ReleaseChanges() { return std::move(m_Changes); }  // Lets the next Build reuse the storage
+
+    // Tempo changes do not have to be sorted; a later change at the same tick wins
+    void Build(uint16_t division, std::vector<TempoChange>&& changes);
+
+    uint64_t TicksToMicroseconds(uint64_t tick) const;
+    uint64_t MicrosecondsToTicks(uint64_t microseconds) const;
+    uint32_t GetTempo(uint64_t tick) const;  // Tempo in effect at tick
+
+    // Index of the tempo change in effect at tick
+    size_t FindChange(uint64_t tick) const;
+
+    // Converts with a known tempo change, used by linear passes over sorted events
+    inline uint64_t TicksToMicroseconds(uint64_t tick, size_t changeIndex) const {
+        const TempoChange& change = m_Changes[changeIndex];
+        return change.Microseconds + (tick - change.Tick) * change.Tempo / m_Division;
+    }
+
+    inline uint16_t GetDivision() const { return m_Division; }
+    inline const std::vector<TempoChange>& GetChanges() const { return m_Changes; }
+private:
+    uint16_t m_Division = 0;
+    std::vector<TempoChange> m_Changes;  // Sorted by tick, always starts at tick 0
+};
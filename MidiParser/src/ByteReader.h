@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Endian.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Big endian reader over a borrowed buffer. Positions are absolute offsets
+// into the buffer so several readers can walk different chunks of one file.
+// Reads are unchecked unless Checked is set; checked reads past the end
+// return 0 and set the overrun flag instead. Padded reads may load up to 4
+// bytes past the value, which the caller guarantees are readable.
+class ByteReader {
+public:
+    ByteReader() = default;
+    ByteReader(const uint8_t* data, size_t size, size_t position = 0)
+        : m_Data(data), m_Size(size), m_Position(position) {}
+
+    inline size_t GetPosition() const { return m_Position; }
+    inline void SetPosition(size_t position) { m_Position = position; }
+    inline size_t GetSize() const { return m_Size; }
+    inline size_t Remaining() const { return m_Position < m_Size ? m_Size - m_Position : 0; }
+
+    inline const uint8_t* Data() const { return m_Data; }
+    inline const uint8_t* Current() const { return m_Data + m_Position; }
+
+    inline bool Overrun() const { return m_Overrun; }
+
+    inline void Skip(size_t size) { m_Position += size; }
+
+    template<bool Checked = false, bool Padded = false>
+    inline int32_t ReadVariableLengthValue() {  // Returns -1 if invalid
+        static_assert(!(Checked && Padded), "A padded read is never checked");
+
+        if constexpr (Padded) {
+            uint32_t length = 4;
+            int32_t value = Simd::ReadVariableLength(m_Data + m_Position, length);
+            m_Position += length;
+            return value;
+        }
+
+        int32_t value = 0;
+
+        for (int i = 0; i < 4; i++) {  // A variable length value is at most 4 bytes
+            uint8_t byte = ReadByte<Checked>();
+            value += (byte & 0b01111111);
+            if (!(byte & 0b10000000))  // If the left bit is 0 (end of value)
+                return value;
+            value <<= 7;
+        }
+
+        return -1;
+    }
+
+    template<bool Checked = false>
+    inline uint8_t ReadByte() {
+        if constexpr (Checked) {
+            if (m_Position >= m_Size) {
+                m_Overrun = true;
+                return 0;
+            }
+        }
+
+        return m_Data[m_Position++];
+    }
+
+    inline uint16_t ReadShort() {
+        uint16_t number;
+        std::memcpy(&number, m_Data + m_Position, sizeof(uint16_t));  // The source may not be aligned
+        m_Position += sizeof(uint16_t);
+
+        if constexpr (Endian::Little)
+            number = Endian::FlipEndian(number);
+
+        return number;
+    }
+
+    inline uint32_t ReadInteger() {
+        uint32_t number;
+        std::memcpy(&number, m_Data + m_Position, sizeof(uint32_t));
+        m_Position += sizeof(uint32_t);
+
+        if constexpr (Endian::Little)
+            number = Endian::FlipEndian(number);
+
+        return number;
+    }
+
+    inline void ReadBytes(uint8_t* buffer, size_t size) {  // Copies memory from the source to buffer
+        std::copy(m_Data + m_Position, m_Data + m_Position + size, buffer);
+        m_Position += size;
+    }
+private:
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+    size_t m_Position = 0;
+    bool m_Overrun = false;
+};
@@ -0,0 +1,181 @@
+#include "ColumnarEvents.h"
+#include "MergedEventView.h"
+#include "MidiParser.h"
+
+#define KEYS_PER_TRACK (16 * 128)  // Channels times pitches
+#define SOUNDING UINT32_MAX  // Duration of a note that has not ended yet
+
+void ColumnarEvents::Reserve(size_t count) {
+    Tick.reserve(count);
+    Track.reserve(count);
+    Channel.reserve(count);
+    Type.reserve(count);
+    DataA.reserve(count);
+    DataB.reserve(count);
+}
+
+void ColumnarEvents::Clear() {
+    Tick.clear();
+    Track.clear();
+    Channel.clear();
+    Type.clear();
+    DataA.clear();
+    DataB.clear();
+}
+
+void ColumnarNotes::Reserve(size_t count) {
+    Start.reserve(count);
+    Duration.reserve(count);
+    Track.reserve(count);
+    Channel.reserve(count);
+    Pitch.reserve(count);
+    Velocity.reserve(count);
+}
+
+void ColumnarNotes::Clear() {
+    Start.clear();
+    Duration.clear();
+    Track.clear();
+    Channel.clear();
+    Pitch.clear();
+    Velocity.clear();
+}
+
+void ColumnarExporter::Export(const MidiTrack& track, uint16_t trackIndex) {
+    Begin(1, track.GetEventCount());
+
+    for (size_t i = 0; i < track.GetEventCount(); i++) {
+        const Event* event = track[i];
+        if (event->GetCategory() != EventCategory::Midi)
+            continue;
+
+        const MidiEvent* midiEvent = static_cast<const MidiEvent*>(event);
+        Append(midiEvent->GetTick(), trackIndex, (MidiEventType)midiEvent->GetType(), midiEvent->GetChannel(), midiEvent->GetDataA(), midiEvent->GetDataB());
+    }
+
+    End(track.TotalTicks());
+}
+
+void ColumnarExporter::Export(const CompactTrack& track, uint16_t trackIndex) {
+    Begin(1, track.GetEventCount());
+
+    for (const CompactEvent& event : track) {
+        if (event.IsMidi())
+            Append(event.Tick, trackIndex, event.GetMidiType(), event.GetChannel(), event.GetDataA(), event.GetDataB());
+    }
+
+    End(track.TotalTicks());
+}
+
+void ColumnarExporter::Export(const MidiParser& parser) {
+    if (parser.GetOptions().Storage == TrackStorage::Compact) {
+        const std::vector<CompactTrack>& tracks = parser.GetCompactTracks();
+
+        size_t eventCount = 0;
+        for (const CompactTrack& track : tracks)
+            eventCount += track.GetEventCount();
+        Begin(tracks.size(), eventCount);
+
+        for (MergedCompactEvents view(tracks); !view.IsEnd(); view.Advance()) {
+            const CompactEvent& event = view.CurrentEvent();
+            if (event.IsMidi())
+                Append(event.Tick, view.CurrentTrack(), event.GetMidiType(), event.GetChannel(), event.GetDataA(), event.GetDataB());
+        }
+    } else {
+        const std::vector<MidiTrack>& tracks = parser.GetTracks();
+
+        size_t eventCount = 0;
+        for (const MidiTrack& track : tracks)
+            eventCount += track.GetEventCount();
+        Begin(tracks.size(), eventCount);
+
+        for (MergedEvents view(tracks); !view.IsEnd(); view.Advance()) {
+            const Event* event = view.CurrentEvent();
+            if (event->GetCategory() != EventCategory::Midi)
+                continue;
+
+            const MidiEvent* midiEvent = static_cast<const MidiEvent*>(event);
+            Append(midiEvent->GetTick(), view.CurrentTrack(), (MidiEventType)midiEvent->GetType(), midiEvent->GetChannel(), midiEvent->GetDataA(), midiEvent->GetDataB());
+        }
+    }
+
+    End((uint32_t)parser.GetTotalTicks());
+}
+
+void ColumnarExporter::Begin(size_t trackCount, size_t eventCount) {
+    m_Merged = trackCount > 1;
+    m_Events.Clear();
+    m_Events.Reserve(eventCount);  // Meta events are counted too, so this is an upper bound
+
+    m_Notes.Clear();
+    m_NextSounding.clear();
+
+    // End() leaves every key empty, so only new keys need initialising
+    if (m_PairNotes && m_FirstSounding.size() < trackCount * KEYS_PER_TRACK) {
+        m_FirstSounding.resize(trackCount * KEYS_PER_TRACK, -1);
+        m_LastSounding.resize(trackCount * KEYS_PER_TRACK, -1);
+    }
+}
+
+inline size_t ColumnarExporter::KeyOf(uint16_t track, uint8_t channel, uint8_t pitch) const {
+    size_t keys = m_Merged ? (size_t)track * KEYS_PER_TRACK : 0;  // A single track only needs one set of keys
+    return keys + (channel & 0x0f) * 128 + (pitch & 0x7f);
+}
+
+inline void ColumnarExporter::Append(uint32_t tick, uint16_t track, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+    m_Events.Tick.push_back(tick);
+    m_Events.Track.push_back(track);
+    m_Events.Channel.push_back(channel);
+    m_Events.Type.push_back(type);
+    m_Events.DataA.push_back(dataA);
+    m_Events.DataB.push_back(dataB);
+
+    if (!m_PairNotes)
+        return;
+
+    size_t key = KeyOf(track, channel, dataA);
+
+    if (type == MidiEventType::NoteOn) {
+        int32_t note = (int32_t)m_Notes.GetSize();
+
+        m_Notes.Start.push_back(tick);
+        m_Notes.Duration.push_back(SOUNDING);
+        m_Notes.Track.push_back(track);
+        m_Notes.Channel.push_back(channel);
+        m_Notes.Pitch.push_back(dataA);
+        m_Notes.Velocity.push_back(dataB);
+        m_NextSounding.push_back(-1);
+
+        if (m_LastSounding[key] < 0)
+            m_FirstSounding[key] = note;
+        else
+            m_NextSounding[m_LastSounding[key]] = note;
+        m_LastSounding[key] = note;
+    } else if (type == MidiEventType::NoteOff) {
+        int32_t note = m_FirstSounding[key];
+        if (note < 0)
+            return;  // Nothing to end
+
+        m_Notes.Duration[note] = tick - m_Notes.Start[note];
+
+        m_FirstSounding[key] = m_NextSounding[note];
+        if (m_FirstSounding[key] < 0)
+            m_LastSounding[key] = -1;
+    }
+}
+
+void ColumnarExporter::End(uint32_t endTick) {
+    if (!m_PairNotes)
+        return;
+
+    for (size_t i = 0; i < m_Notes.GetSize(); i++) {
+        if (m_Notes.Duration[i] != SOUNDING)
+            continue;
+
+        m_Notes.Duration[i] = endTick > m_Notes.Start[i] ? endTick - m_Notes.Start[i] : 0;
+
+        size_t key = KeyOf(m_Notes.Track[i], m_Notes.Channel[i], m_Notes.Pitch[i]);
+        m_FirstSounding[key] = -1;
+        m_LastSounding[key] = -1;
+    }
+}
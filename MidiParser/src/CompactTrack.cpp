@@ -0,0 +1,47 @@
+#include "CompactTrack.h"
+#include "Instrumentation.h"
+
+void CompactTrack::Reserve(size_t eventCount, size_t payloadCount, size_t payloadBytes) {
+    MIDI_STATS_RESERVE(m_Events, eventCount);
+    MIDI_STATS_RESERVE(m_Payloads, payloadCount);
+    MIDI_STATS_RESERVE(m_PayloadData, payloadBytes);
+    m_Events.reserve(eventCount);
+    m_Payloads.reserve(payloadCount);
+    m_PayloadData.reserve(payloadBytes);
+}
+
+void CompactTrack::Clear() {
+    m_Events.clear();
+    m_Payloads.clear();
+    m_PayloadData.clear();
+    m_TotalTicks = 0;
+}
+
+void CompactTrack::AppendMidiEvent(uint32_t tick, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+    MIDI_STATS_APPEND(m_Events, 1);
+    m_Events.push_back({ tick, EventCategory::Midi, { (uint8_t)(type | channel), dataA, dataB } });
+}
+
+void CompactTrack::AppendMetaEvent(uint32_t tick, MetaEventType type, const uint8_t* data, uint32_t size) {
+    uint32_t index = (uint32_t)m_Payloads.size();
+
+    MIDI_STATS_APPEND(m_Payloads, 1);
+    MIDI_STATS_APPEND(m_PayloadData, size);
+    MIDI_STATS_APPEND(m_Events, 1);
+
+    m_Payloads.push_back({ (uint32_t)m_PayloadData.size(), size, type });
+    m_PayloadData.insert(m_PayloadData.end(), data, data + size);
+
+    m_Events.push_back({ tick, EventCategory::Meta, { (uint8_t)index, (uint8_t)(index >> 8), (uint8_t)(index >> 16) } });
+}
+
+void CompactTrack::AppendSysExEvent(uint32_t tick, EventCategory category, SysExPacket packet, const uint8_t* data, uint32_t size) {
+    uint32_t index = (uint32_t)m_Payloads.size();
+
+    MIDI_STATS_APPEND(m_Payloads, 1);
+    MIDI_STATS_APPEND(m_Events, 1);
+
+    m_Payloads.push_back({ (uint32_t)(data - m_SourceData), size, (uint8_t)packet });
+
+    m_Events.push_back({ tick, category, { (uint8_t)index, (uint8_t)(index >> 8), (uint8_t)(index >> 16) } });
+}
@@ -0,0 +1,130 @@
+#include "ControllerIndex.h"
+#include "MergedEventView.h"
+#include "MidiParser.h"
+
+#include <algorithm>
+#include <cstring>
+
+#define RESET_ALL_CONTROLLERS 121
+
+void ChannelState::Reset() {
+    std::memset(Controllers, Unset, sizeof(Controllers));
+    Program = Unset;
+    Pressure = Unset;
+    PitchBend = UnsetPitchBend;
+}
+
+void ChannelState::Apply(MidiEventType type, uint8_t dataA, uint8_t dataB) {
+    dataA &= 0x7f;
+    dataB &= 0x7f;
+
+    switch (type) {
+        case MidiEventType::ControlChange:
+            if (dataA < 120) {
+                Controllers[dataA] = dataB;
+            } else if (dataA == RESET_ALL_CONTROLLERS) {
+                // What the receiver resets (RP-015); volume, pan, banks and program are kept
+                Controllers[1] = 0;  // Modulation
+                Controllers[11] = 127;  // Expression
+                std::memset(Controllers + 64, 0, 4);  // Sustain, portamento, sostenuto and soft pedals
+                std::memset(Controllers + 98, 127, 4);  // No RPN or NRPN selected
+                Pressure = 0;
+                PitchBend = 8192;
+            }
+            break;
+        case MidiEventType::ProgramChange:
+            Program = dataA;
+            break;
+        case MidiEventType::ChannelAfterTouch:
+            Pressure = dataA;
+            break;
+        case MidiEventType::PitchBend:
+            PitchBend = (uint16_t)(dataA | dataB << 7);
+            break;
+        default:
+            break;
+    }
+}
+
+inline void ControllerIndex::AddEvent(uint32_t tick, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+    switch (type) {
+        case MidiEventType::ControlChange:
+        case MidiEventType::ProgramChange:
+        case MidiEventType::ChannelAfterTouch:
+        case MidiEventType::PitchBend:
+            m_Events.push_back({ tick, (uint8_t)(type | channel), dataA, dataB });
+            break;
+        default:
+            break;  // Notes and poly aftertouch do not change the state
+    }
+}
+
+void ControllerIndex::Build(const MidiParser& parser, uint32_t eventInterval, uint32_t tickInterval) {
+    m_Events.clear();
+
+    if (parser.GetOptions().Storage == TrackStorage::Compact) {
+        for (MergedCompactEvents view(parser.GetCompactTracks()); !view.IsEnd(); view.Advance()) {
+            const CompactEvent& event = view.CurrentEvent();
+            if (event.IsMidi())
+                AddEvent(event.Tick, event.GetMidiType(), event.GetChannel(), event.GetDataA(), event.GetDataB());
+        }
+    } else {
+        for (MergedEvents view(parser.GetTracks()); !view.IsEnd(); view.Advance()) {
+            const Event* event = view.CurrentEvent();
+            if (event->GetCategory() != EventCategory::Midi)
+                continue;
+
+            const MidiEvent* midiEvent = static_cast<const MidiEvent*>(event);
+            AddEvent(midiEvent->GetTick(), (MidiEventType)midiEvent->GetType(), midiEvent->GetChannel(), midiEvent->GetDataA(), midiEvent->GetDataB());
+        }
+    }
+
+    AddCheckpoints(eventInterval, tickInterval);
+}
+
+void ControllerIndex::AddCheckpoints(uint32_t eventInterval, uint32_t tickInterval) {
+    m_Checkpoints.clear();
+    m_States.clear();
+
+    if (eventInterval != 0)
+        m_Checkpoints.reserve(m_Events.size() / eventInterval + 1);
+
+    ControllerState state;
+    m_Checkpoints.push_back(0);
+    m_States.push_back(state);
+
+    uint32_t lastEvent = 0, lastTick = 0;
+    for (uint32_t i = 0; i < (uint32_t)m_Events.size(); i++) {
+        const Entry& entry = m_Events[i];
+
+        bool eventsDue = eventInterval != 0 && i - lastEvent >= eventInterval;
+        bool ticksDue = tickInterval != 0 && i != lastEvent && entry.Tick - lastTick >= tickInterval;
+        if (eventsDue || ticksDue) {
+            m_Checkpoints.push_back(i);
+            m_States.push_back(state);
+            lastEvent = i;
+            lastTick = entry.Tick;
+        }
+
+        state.Apply((MidiEventType)(entry.Status & 0xf0), entry.Status & 0x0f, entry.DataA, entry.DataB);
+    }
+}
+
+void ControllerIndex::StateAt(uint32_t tick, ControllerState& state) const {
+    // First event on or after tick, then the last snapshot that leaves it out
+    uint32_t end = (uint32_t)(std::lower_bound(m_Events.begin(), m_Events.end(), tick,
+        [](const Entry& entry, uint32_t tick) { return entry.Tick < tick; }) - m_Events.begin());
+
+    if (m_Checkpoints.empty()) {
+        state.Reset();
+        return;
+    }
+
+    size_t checkpoint = std::upper_bound(m_Checkpoints.begin(), m_Checkpoints.end(), end) - m_Checkpoints.begin() - 1;
+    state = m_States[checkpoint];
+
+    for (uint32_t i = m_Checkpoints[checkpoint]; i < end; i++) {
+        const Entry& entry = m_Events[i];
+        state.Apply((MidiEventType)(entry.Status & 0xf0), entry.Status & 0x0f, entry.DataA, entry.DataB);
+    }
+}
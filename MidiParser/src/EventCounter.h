@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct EventCounts {
+    size_t MidiEvents = 0;
+    size_t MetaEvents = 0;  // Without the end of track event, which is not stored
+    size_t SysExEvents = 0;
+    size_t MetaBytes = 0;  // Meta data is copied; SysEx data is not
+};
+
+// Counts the events of a track chunk without decoding them, so the track can
+// be allocated once at its exact size. It only skips over delta times and
+// payloads, at about a third of the cost of parsing. Returns false if the
+// chunk is malformed; the parse that follows finds and reports the error.
+inline bool CountEvents(const uint8_t* data, size_t size, EventCounts& counts) {
+    const uint8_t* end = data + size;
+    uint8_t runningStatus = 0;
+
+    // Skips a variable length value and returns it, or returns UINT32_MAX if it is invalid
+    auto skipValue = [&data, end]() -> uint32_t {
+        uint32_t value = 0;
+        for (int i = 0; i < 4 && data < end; i++) {
+            uint8_t byte = *data++;
+            value = value << 7 | (byte & 0x7f);
+            if (!(byte & 0x80))
+                return value;
+        }
+        return UINT32_MAX;
+    };
+
+    while (data < end) {
+        if (skipValue() == UINT32_MAX || data >= end)  // Delta time
+            return false;
+
+        uint8_t status = *data;
+        if (status < 0x80) {  // Running status; the byte is the first data byte
+            if (runningStatus == 0)
+                return false;
+            status = runningStatus;
+        } else {
+            data++;
+        }
+
+        if (status == 0xff) {
+            if (data >= end)
+                return false;
+
+            uint8_t type = *data++;
+            uint32_t length = skipValue();
+            if (length > (size_t)(end - data))
+                return false;
+
+            data += length;
+            runningStatus = 0;
+
+            if (type == 0x2f)  // End of track
+                return true;
+
+            counts.MetaEvents++;
+            counts.MetaBytes += length;
+        } else if (status == 0xf0 || status == 0xf7) {
+            uint32_t length = skipValue();
+            if (length > (size_t)(end - data))
+                return false;
+
+            data += length;
+            runningStatus = 0;
+            counts.SysExEvents++;
+        } else if (status >= 0xf0) {
+            return false;
+        } else {
+            runningStatus = status;
+            data += (status & 0xe0) == 0xc0 ? 1 : 2;  // Program change and channel aftertouch have one data byte
+            counts.MidiEvents++;
+        }
+    }
+
+    return data == end;
+}
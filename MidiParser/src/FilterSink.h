@@ -0,0 +1,40 @@
+#pragma once
+
+#include "EventFilter.h"
+#include "Instrumentation.h"
+#include "MidiEvent.h"
+
+#include <cstdint>
+
+// Stands in for a track when MidiParser reads with a filter, and passes the
+// accepted events on to it. The caller copies m_TotalTicks back afterwards.
+template<typename Track>
+struct FilterSink {
+    uint32_t m_TotalTicks = 0;
+
+    Track& Target;
+    const EventFilter& Filter;
+
+    FilterSink(Track& target, const EventFilter& filter) : Target(target), Filter(filter) {}
+
+    inline void AppendMidiEvent(uint32_t tick, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+        if (Filter.AcceptsMidi(type, channel))
+            Target.AppendMidiEvent(tick, type, channel, dataA, dataB);
+        else
+            MIDI_STATS_COUNT(FilteredEvents, 1);
+    }
+
+    inline void AppendMetaEvent(uint32_t tick, MetaEventType type, const uint8_t* data, uint32_t size) {
+        if (Filter.AcceptsMeta(type))
+            Target.AppendMetaEvent(tick, type, data, size);
+        else
+            MIDI_STATS_COUNT(FilteredEvents, 1);
+    }
+
+    inline void AppendSysExEvent(uint32_t tick, EventCategory category, SysExPacket packet, const uint8_t* data, uint32_t size) {
+        if (Filter.AcceptsSysEx())
+            Target.AppendSysExEvent(tick, category, packet, data, size);
+        else
+            MIDI_STATS_COUNT(FilteredEvents, 1);
+    }
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ParseStats.h"
+
+// Counting and timing hooks for ParseStats. Without MIDI_PARSER_STATS every
+// macro expands to nothing, so the parser is built exactly as before.
+#ifdef MIDI_PARSER_STATS
+
+#include <chrono>
+
+// The stats the current thread reports to. Null outside of a parse, so the
+// stream parser and GetTrackName, which share ReadEvent, are not counted.
+inline ParseStats*& CurrentStats() {
+    static thread_local ParseStats* stats = nullptr;
+    return stats;
+}
+
+// Sends this thread's counters to stats until the end of the scope
+class StatsScope {
+public:
+    StatsScope(ParseStats& stats) : m_Previous(CurrentStats()) { CurrentStats() = &stats; }
+    StatsScope(const StatsScope& other) = delete;
+
+    ~StatsScope() { CurrentStats() = m_Previous; }
+
+    StatsScope& operator=(const StatsScope& other) = delete;
+private:
+    ParseStats* m_Previous;
+};
+
+// Adds the time until the end of the scope to one stage
+class StageTimer {
+public:
+    StageTimer(uint64_t ParseStats::* stage) : m_Stats(CurrentStats()), m_Stage(stage), m_Start(std::chrono::steady_clock::now()) {}
+    StageTimer(const StageTimer& other) = delete;
+
+    ~StageTimer() {
+        if (m_Stats)
+            m_Stats->*m_Stage += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start).count();
+    }
+
+    StageTimer& operator=(const StageTimer& other) = delete;
+private:
+    ParseStats* m_Stats;
+    uint64_t ParseStats::* m_Stage;
+    std::chrono::steady_clock::time_point m_Start;
+};
+
+inline void CountAllocation(bool growth) {
+    if (ParseStats* stats = CurrentStats()) {
+        stats->Allocations++;
+        stats->TrackGrowths += growth;
+    }
+}
+
+#define MIDI_STATS(statement) statement
+#define MIDI_STATS_SCOPE(stats) StatsScope statsScope(stats)
+#define MIDI_STATS_TIMER(stage) StageTimer stageTimer(&ParseStats::stage)
+#define MIDI_STATS_COUNT(counter, amount) do { if (ParseStats* stats = CurrentStats()) stats->counter += (amount); } while (0)
+#define MIDI_STATS_ALLOCATION(growth) CountAllocation(growth)
+// Counts the allocation a vector makes when count more elements do not fit
+#define MIDI_STATS_APPEND(buffer, count) do { if ((buffer).size() + (count) > (buffer).capacity()) CountAllocation((buffer).capacity() != 0); } while (0)
+#define MIDI_STATS_RESERVE(buffer, count) do { if ((size_t)(count) > (buffer).capacity()) CountAllocation((buffer).capacity() != 0); } while (0)
+
+#else
+
+#define MIDI_STATS(statement)
+#define MIDI_STATS_SCOPE(stats)
+#define MIDI_STATS_TIMER(stage)
+// Statements still, so they can be the body of an if or else
+#define MIDI_STATS_COUNT(counter, amount) do {} while (0)
+#define MIDI_STATS_ALLOCATION(growth) do {} while (0)
+#define MIDI_STATS_APPEND(buffer, count) do {} while (0)
+#define MIDI_STATS_RESERVE(buffer, count) do {} while (0)
+
+#endif
@@ -0,0 +1,143 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (&other != this) {
+        Close();
+
+        m_Data = other.m_Data;
+        m_Size = other.m_Size;
+        m_Opened = other.m_Opened;
+#ifdef _WIN32
+        m_FileHandle = other.m_FileHandle;
+        m_MappingHandle = other.m_MappingHandle;
+
+        other.m_FileHandle = nullptr;
+        other.m_MappingHandle = nullptr;
+#endif
+
+        other.m_Data = nullptr;
+        other.m_Size = 0;
+        other.m_Opened = false;
+    }
+
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& file) {
+    Close();
+
+    HANDLE fileHandle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size)) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    m_FileHandle = fileHandle;
+    m_Size = (size_t)size.QuadPart;
+    m_Opened = true;
+
+    if (m_Size == 0)  // Empty files cannot be mapped
+        return true;
+
+    m_MappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_MappingHandle == nullptr) {
+        Close();
+        return false;
+    }
+
+    m_Data = (const uint8_t*)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (m_Data == nullptr) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_Data != nullptr)
+        UnmapViewOfFile(m_Data);
+    if (m_MappingHandle != nullptr)
+        CloseHandle(m_MappingHandle);
+    if (m_FileHandle != nullptr)
+        CloseHandle(m_FileHandle);
+
+    m_Data = nullptr;
+    m_MappingHandle = nullptr;
+    m_FileHandle = nullptr;
+    m_Size = 0;
+    m_Opened = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& file) {
+    Close();
+
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+
+    m_Size = (size_t)info.st_size;
+    m_Opened = true;
+
+    if (m_Size > 0) {  // Empty files cannot be mapped
+        void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            m_Size = 0;
+            m_Opened = false;
+            return false;
+        }
+
+        madvise(data, m_Size, MADV_SEQUENTIAL);  // The parser reads the file front to back
+        m_Data = (const uint8_t*)data;
+    }
+
+    close(fd);  // The mapping stays valid after the descriptor is closed
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_Data != nullptr)
+        munmap((void*)m_Data, m_Size);
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Opened = false;
+}
+
+#endif
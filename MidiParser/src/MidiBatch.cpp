@@ -0,0 +1,70 @@
+#include "MidiBatch.h"
+#include "ThreadPool.h"
+
+static inline bool OpenInput(MidiParser& parser, const std::string& file) {
+    return parser.Open(file);
+}
+
+static inline bool OpenInput(MidiParser& parser, const MidiBuffer& buffer) {
+    return parser.Open(buffer.Data, buffer.Size);
+}
+
+MidiBatchParser::MidiBatchParser(const ParseOptions& options, unsigned threads)
+    : m_Options(options), m_ThreadPool(std::make_unique<ThreadPool>(threads)) {
+
+    m_Options.Threads = 1;  // Files run in parallel, so each file's tracks are parsed serially
+    m_Workers.resize(m_ThreadPool->GetThreadCount(), MidiParser(m_Options));
+}
+
+MidiBatchParser::~MidiBatchParser() = default;
+
+unsigned MidiBatchParser::GetThreadCount() const {
+    return m_ThreadPool->GetThreadCount();
+}
+
+void MidiBatchParser::ForEach(const std::vector<std::string>& files, const Callback& callback) {
+    Run(files, callback);
+}
+
+void MidiBatchParser::ForEach(const std::vector<MidiBuffer>& buffers, const Callback& callback) {
+    Run(buffers, callback);
+}
+
+std::vector<MidiBatchResult> MidiBatchParser::ParseAll(const std::vector<std::string>& files) {
+    return RunAll(files);
+}
+
+std::vector<MidiBatchResult> MidiBatchParser::ParseAll(const std::vector<MidiBuffer>& buffers) {
+    return RunAll(buffers);
+}
+
+template<typename Input>
+void MidiBatchParser::Run(const std::vector<Input>& inputs, const Callback& callback) {
+    m_ThreadPool->ParallelFor(inputs.size(), [&](size_t index, unsigned worker) {
+        MidiParser& parser = m_Workers[worker];
+        bool success = OpenInput(parser, inputs[index]);
+        callback(index, parser, success);
+    });
+}
+
+template<typename Input>
+std::vector<MidiBatchResult> MidiBatchParser::RunAll(const std::vector<Input>& inputs) {
+    std::vector<MidiBatchResult> results(inputs.size());
+
+    m_ThreadPool->ParallelFor(inputs.size(), [&](size_t index, unsigned worker) {
+        MidiBatchResult& result = results[index];
+        MidiParser& parser = m_Workers[worker];
+
+        result.Success = OpenInput(parser, inputs[index]);
+        result.Error = parser.GetError();
+
+        // The result takes the parsed file and the worker starts over; a file
+        // that failed leaves its buffers to the worker's next file instead
+        if (result.Success) {
+            result.Parser = std::make_unique<MidiParser>(std::move(parser));
+            parser = MidiParser(m_Options);
+        }
+    });
+
+    return results;
+}
@@ -0,0 +1,376 @@
+#include "MidiCache.h"
+#include "MappedFile.h"
+#include "MidiParser.h"
+#include "PayloadArena.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+
+#define CACHE_MAGIC 0x4643504d  // "MPCF" in little endian
+#define CACHE_VERSION 1  // Bump whenever the layout or the meaning of a field changes
+#define CACHE_BYTE_ORDER 0x01020304  // Written in the writer's byte order
+
+#define CACHE_LENIENT 0x1  // Parsed with ParseOptions::Lenient
+
+// Everything is stored in the writer's byte order and aligned to 8 bytes so
+// the arrays can be used straight from the mapping
+struct CacheHeader {
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t ByteOrder;
+    uint32_t Flags;
+
+    uint64_t SourceSize;
+    int64_t SourceModified;  // In file clock ticks
+    uint64_t SourceHash;
+
+    uint64_t TotalTicks;
+    uint16_t Format;
+    uint16_t TrackCount;
+    uint16_t Division;
+    uint16_t Reserved;
+    uint32_t TempoChangeCount;
+    uint32_t Reserved2;
+};
+
+struct CacheTrack {
+    uint64_t ChunkOffset;  // Track chunk in the source file
+    uint32_t ChunkSize;
+    uint32_t TotalTicks;
+
+    uint64_t Events;  // File offsets of the arrays
+    uint64_t EventCount;
+    uint64_t Payloads;
+    uint64_t PayloadCount;
+    uint64_t PayloadData;
+    uint64_t PayloadDataSize;
+};
+
+static_assert(std::is_trivially_copyable_v<CompactEvent> && std::is_trivially_copyable_v<CompactPayload>, "Cached arrays are copied as bytes");
+static_assert(sizeof(TempoChange) == 16 && sizeof(CacheHeader) % 8 == 0 && sizeof(CacheTrack) % 8 == 0, "Cache records must stay aligned");
+
+static inline size_t Align(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+// FNV-1a style mixing over 8 byte words in four independent lanes, so the
+// multiplies overlap. It only has to notice that the source changed.
+static uint64_t Hash(const uint8_t* data, size_t size) {
+    const uint64_t prime = 0x100000001b3;
+    uint64_t lanes[4] = { 0xcbf29ce484222325, 0x84222325cbf29ce4, 0xcbf29ce4cbf29ce4, 0x8422232584222325 };
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (size_t lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            std::memcpy(&word, data + i + lane * 8, sizeof(uint64_t));
+            lanes[lane] = (lanes[lane] ^ word) * prime;
+        }
+    }
+
+    uint64_t hash = size;
+    for (uint64_t lane : lanes)
+        hash = (hash ^ lane ^ (lane >> 29)) * prime;
+    for (; i < size; i++)
+        hash = (hash ^ data[i]) * prime;
+
+    return hash;
+}
+
+// memcpy must not be given a null pointer, which empty vectors may have
+static inline void CopyBytes(void* destination, const void* source, size_t size) {
+    if (size != 0)
+        std::memcpy(destination, source, size);
+}
+
+static bool GetSourceStamp(const std::string& file, uint64_t& size, int64_t& modified) {
+    std::error_code error;
+    size = std::filesystem::file_size(file, error);
+    if (error)
+        return false;
+
+    auto time = std::filesystem::last_write_time(file, error);
+    if (error)
+        return false;
+
+    modified = (int64_t)time.time_since_epoch().count();
+    return true;
+}
+
+static inline uint32_t FlagsOf(const ParseOptions& options) {
+    return options.Lenient ? CACHE_LENIENT : 0;
+}
+
+bool MidiCache::Open(MidiParser& parser, const std::string& file, const std::string& cacheFile) const {
+    if (Load(parser, file, cacheFile))
+        return true;
+
+    if (!parser.Open(file))
+        return false;
+
+    Save(parser, file, cacheFile);  // The parse is still good if the cache cannot be written
+    return true;
+}
+
+bool MidiCache::Load(MidiParser& parser, const std::string& file, const std::string& cacheFile) const {
+    if (!parser.m_Options.Filter.AcceptsAll())
+        return false;  // Only whole files are cached
+
+    MappedFile cache;
+    if (!cache.Open(cacheFile) || cache.Size() < sizeof(CacheHeader))
+        return false;
+
+    const uint8_t* data = cache.Data();
+    size_t size = cache.Size();
+
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(CacheHeader));
+
+    if (header.Magic != CACHE_MAGIC || header.Version != CACHE_VERSION || header.ByteOrder != CACHE_BYTE_ORDER)
+        return false;
+    if (header.Flags != FlagsOf(parser.m_Options) || header.Division == 0 || (header.Division & 0x8000))
+        return false;
+
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    if (!GetSourceStamp(file, sourceSize, sourceModified) || sourceSize != header.SourceSize || sourceModified != header.SourceModified)
+        return false;
+
+    // SysEx data points into the source, as it does after a normal parse
+    auto source = std::make_shared<MappedFile>();
+    if (!source->Open(file) || source->Size() != header.SourceSize)
+        return false;
+    if (m_HashCheck && Hash(source->Data(), source->Size()) != header.SourceHash)
+        return false;
+
+    size_t tempoOffset = sizeof(CacheHeader);
+    size_t tracksOffset = tempoOffset + (size_t)header.TempoChangeCount * sizeof(TempoChange);
+    if (tracksOffset + (size_t)header.TrackCount * sizeof(CacheTrack) > size)
+        return false;
+
+    // Save writes the tempo map as built: sorted by tick, with no zero tempo to divide by
+    uint32_t previousTick = 0;
+    for (size_t i = 0; i < header.TempoChangeCount; i++) {
+        TempoChange change;
+        std::memcpy(&change, data + tempoOffset + i * sizeof(TempoChange), sizeof(TempoChange));
+
+        if (change.Tempo == 0 || change.Tick < previousTick)
+            return false;
+        previousTick = change.Tick;
+    }
+
+    // Checks every array and payload reference, so a damaged cache is rejected instead of read out of bounds
+    auto inside = [size](uint64_t offset, uint64_t count, size_t elementSize) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+    };
+
+    std::vector<CacheTrack> tracks(header.TrackCount);
+    for (size_t i = 0; i < tracks.size(); i++) {
+        CacheTrack& track = tracks[i];
+        std::memcpy(&track, data + tracksOffset + i * sizeof(CacheTrack), sizeof(CacheTrack));
+
+        if (!inside(track.Events, track.EventCount, sizeof(CompactEvent)) || !inside(track.Payloads, track.PayloadCount, sizeof(CompactPayload)) ||
+            !inside(track.PayloadData, track.PayloadDataSize, 1))
+            return false;
+        if (track.ChunkOffset > source->Size() || track.ChunkSize > source->Size() - track.ChunkOffset)
+            return false;
+
+        const CompactEvent* events = (const CompactEvent*)(data + track.Events);
+        const CompactPayload* payloads = (const CompactPayload*)(data + track.Payloads);
+
+        for (size_t e = 0; e < track.EventCount; e++) {
+            const CompactEvent& event = events[e];
+            if (event.Category == EventCategory::Midi)
+                continue;
+            if (event.Category != EventCategory::Meta && event.Category != EventCategory::SysEx && event.Category != EventCategory::EndSysEx)
+                return false;  // Would be read as a SysEx packet otherwise
+
+            uint32_t index = event.GetPayloadIndex();
+            if (index >= track.PayloadCount)
+                return false;
+
+            uint64_t limit = event.Category == EventCategory::Meta ? track.PayloadDataSize : source->Size();
+            if ((uint64_t)payloads[index].Offset + payloads[index].Size > limit)
+                return false;
+        }
+    }
+
+    // The cache is good, so the parser can drop its previous file
+    parser.m_File = source;
+    parser.Reset(source->Data(), source->Size());
+
+    parser.m_Format = header.Format;
+    parser.m_TrackCount = header.TrackCount;
+    parser.m_Division = header.Division;
+    parser.m_TotalTicks = header.TotalTicks;
+
+    std::vector<TempoChange> changes(header.TempoChangeCount);
+    CopyBytes(changes.data(), data + tempoOffset, changes.size() * sizeof(TempoChange));
+    parser.m_TempoMap.Build(header.Division, std::move(changes));
+    parser.m_Duration = parser.m_TempoMap.TicksToMicroseconds(parser.m_TotalTicks);
+
+    parser.m_Chunks.clear();
+    for (const CacheTrack& track : tracks)
+        parser.m_Chunks.push_back({ (size_t)track.ChunkOffset, track.ChunkSize });
+
+    if (parser.m_Options.Storage == TrackStorage::Compact) {
+        parser.TakeTracks(parser.m_CompactTrackList, tracks.size());
+
+        for (size_t i = 0; i < tracks.size(); i++) {
+            const CacheTrack& cached = tracks[i];
+            CompactTrack& track = parser.m_CompactTrackList[i];
+
+            const CompactEvent* events = (const CompactEvent*)(data + cached.Events);
+            const CompactPayload* payloads = (const CompactPayload*)(data + cached.Payloads);
+
+            track.m_Events.assign(events, events + cached.EventCount);
+            track.m_Payloads.assign(payloads, payloads + cached.PayloadCount);
+            track.m_PayloadData.assign(data + cached.PayloadData, data + cached.PayloadData + cached.PayloadDataSize);
+            track.m_SourceData = source->Data();
+            track.m_Source = source;
+            track.m_TotalTicks = cached.TotalTicks;
+        }
+    } else {
+        parser.TakeTracks(parser.m_TrackList, tracks.size());
+
+        // Polymorphic events have to be built, but nothing is decoded from the MIDI bytes
+        for (size_t i = 0; i < tracks.size(); i++) {
+            const CacheTrack& cached = tracks[i];
+            MidiTrack& track = parser.m_TrackList[i];
+            parser.PrepareTrack(track);
+
+            const CompactEvent* events = (const CompactEvent*)(data + cached.Events);
+            const CompactPayload* payloads = (const CompactPayload*)(data + cached.Payloads);
+
+            track.ReserveEvents(cached.EventCount);
+            if (cached.PayloadDataSize > 0)
+                track.m_Payloads->Reserve(cached.PayloadDataSize);
+
+            for (size_t e = 0; e < cached.EventCount; e++) {
+                const CompactEvent& event = events[e];
+
+                if (event.Category == EventCategory::Midi) {
+                    track.AppendMidiEvent(event.Tick, event.GetMidiType(), event.GetChannel(), event.GetDataA(), event.GetDataB());
+                } else {
+                    const CompactPayload& payload = payloads[event.GetPayloadIndex()];
+                    if (event.Category == EventCategory::Meta)
+                        track.AppendMetaEvent(event.Tick, (MetaEventType)payload.Type, data + cached.PayloadData + payload.Offset, payload.Size);
+                    else
+                        track.AppendSysExEvent(event.Tick, event.Category, (SysExPacket)payload.Type, source->Data() + payload.Offset, payload.Size);
+                }
+            }
+
+            track.m_TotalTicks = cached.TotalTicks;
+            parser.SetEventTimes(track);
+        }
+    }
+
+    return true;
+}
+
+bool MidiCache::Save(const MidiParser& parser, const std::string& file, const std::string& cacheFile) const {
+    if (!parser.m_ErrorStatus || parser.m_Data == nullptr || !parser.m_Options.Filter.AcceptsAll())
+        return false;
+
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    if (!GetSourceStamp(file, sourceSize, sourceModified) || sourceSize != parser.m_Size)
+        return false;
+
+    // The cache holds compact tracks; other parsers are parsed again into that form
+    const MidiParser* compact = &parser;
+    MidiParser reparsed;
+    if (parser.m_Options.Storage != TrackStorage::Compact) {
+        ParseOptions options = parser.m_Options;
+        options.Storage = TrackStorage::Compact;
+        options.Lazy = false;
+        options.OnError = nullptr;
+
+        reparsed.SetOptions(options);
+        if (!reparsed.Open(parser.m_Data, parser.m_Size))
+            return false;
+        compact = &reparsed;
+    }
+
+    const std::vector<CompactTrack>& tracks = compact->GetCompactTracks();
+    const std::vector<TempoChange>& changes = compact->GetTempoMap().GetChanges();
+    if (!compact->m_ErrorStatus)
+        return false;  // A lazily decoded track failed
+
+    CacheHeader header = {};
+    header.Magic = CACHE_MAGIC;
+    header.Version = CACHE_VERSION;
+    header.ByteOrder = CACHE_BYTE_ORDER;
+    header.Flags = FlagsOf(parser.m_Options);
+    header.SourceSize = sourceSize;
+    header.SourceModified = sourceModified;
+    header.SourceHash = Hash(parser.m_Data, parser.m_Size);
+    header.TotalTicks = compact->GetTotalTicks();
+    header.Format = compact->m_Format;
+    header.TrackCount = (uint16_t)tracks.size();
+    header.Division = compact->m_Division;
+    header.TempoChangeCount = (uint32_t)changes.size();
+
+    // Lays out the arrays after the header, the tempo changes and the track table
+    size_t size = sizeof(CacheHeader) + changes.size() * sizeof(TempoChange) + tracks.size() * sizeof(CacheTrack);
+    std::vector<CacheTrack> cachedTracks(tracks.size());
+
+    for (size_t i = 0; i < tracks.size(); i++) {
+        const CompactTrack& track = tracks[i];
+        CacheTrack& cached = cachedTracks[i];
+
+        cached.ChunkOffset = compact->m_Chunks[i].Offset;
+        cached.ChunkSize = compact->m_Chunks[i].Size;
+        cached.TotalTicks = track.m_TotalTicks;
+
+        cached.Events = size;
+        cached.EventCount = track.m_Events.size();
+        size = Align(size + track.m_Events.size() * sizeof(CompactEvent));
+
+        cached.Payloads = size;
+        cached.PayloadCount = track.m_Payloads.size();
+        size = Align(size + track.m_Payloads.size() * sizeof(CompactPayload));
+
+        cached.PayloadData = size;
+        cached.PayloadDataSize = track.m_PayloadData.size();
+        size = Align(size + track.m_PayloadData.size());
+    }
+
+    std::vector<uint8_t> buffer(size, 0);
+    uint8_t* output = buffer.data();
+
+    std::memcpy(output, &header, sizeof(CacheHeader));
+    CopyBytes(output + sizeof(CacheHeader), changes.data(), changes.size() * sizeof(TempoChange));
+    CopyBytes(output + sizeof(CacheHeader) + changes.size() * sizeof(TempoChange), cachedTracks.data(), cachedTracks.size() * sizeof(CacheTrack));
+
+    for (size_t i = 0; i < tracks.size(); i++) {
+        const CompactTrack& track = tracks[i];
+        const CacheTrack& cached = cachedTracks[i];
+
+        CopyBytes(output + cached.Events, track.m_Events.data(), track.m_Events.size() * sizeof(CompactEvent));
+        CopyBytes(output + cached.Payloads, track.m_Payloads.data(), track.m_Payloads.size() * sizeof(CompactPayload));
+        CopyBytes(output + cached.PayloadData, track.m_PayloadData.data(), track.m_PayloadData.size());
+    }
+
+    // Written next to the cache and renamed over it, so readers never see half a file
+    std::string temporary = cacheFile + ".tmp";
+    std::FILE* stream = std::fopen(temporary.c_str(), "wb");
+    if (stream == nullptr)
+        return false;
+
+    bool success = std::fwrite(buffer.data(), 1, buffer.size(), stream) == buffer.size();
+    success = std::fclose(stream) == 0 && success;
+
+    std::error_code error;
+    if (success)
+        std::filesystem::rename(temporary, cacheFile, error);
+    if (!success || error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,26 @@
+#include "MidiError.h"
+
+const char* MidiErrorToString(MidiErrorCode code) {
+    switch (code) {
+        case MidiErrorCode::None:                  return "No error";
+        case MidiErrorCode::CouldNotOpenFile:      return "Could not open file";
+        case MidiErrorCode::FileTooSmall:          return "Invalid MIDI header: file is too small";
+        case MidiErrorCode::InvalidHeaderChunk:    return "Invalid MIDI header: expected string \"MThd\"";
+        case MidiErrorCode::InvalidHeaderSize:     return "Invalid MIDI header: header size is not 6";
+        case MidiErrorCode::InvalidFormat:         return "Invalid MIDI header: invalid MIDI format";
+        case MidiErrorCode::InvalidDivision:       return "Invalid MIDI header: division is 0";
+        case MidiErrorCode::UnsupportedDivision:   return "Division mode not supported";
+        case MidiErrorCode::UnsupportedFormat:     return "Type 2 MIDI format not supported";
+        case MidiErrorCode::MissingTrackChunk:     return "Invalid track: expected string \"MTrk\"";
+        case MidiErrorCode::InvalidTrackSize:      return "Invalid track size";
+        case MidiErrorCode::InvalidVariableLength: return "Unable to read variable length value";
+        case MidiErrorCode::EventOutOfBounds:      return "Event runs past the end of the track";
+        case MidiErrorCode::PayloadOutOfBounds:    return "Event data runs past the end of the track";
+        case MidiErrorCode::MissingRunningStatus:  return "Data byte without a running status";
+        case MidiErrorCode::UnrecognizedEvent:     return "Unrecognized event type";
+        case MidiErrorCode::TooManyPayloads:       return "Too many meta and SysEx events in one compact track";
+        case MidiErrorCode::EventTooLarge:         return "Event is larger than the stream buffer limit";
+    }
+
+    return "Unknown error";
+}
@@ -1,238 +1,642 @@
 #include "MidiParser.h"
-#include "Endian.h"
+#include "ByteReader.h"
+#include "EventCounter.h"
+#include "FilterSink.h"
+#include "Instrumentation.h"
+#include "MappedFile.h"
 #include "MidiEvent.h"
+#include "PayloadArena.h"
+#include "Simd.h"
+#include "StatusTable.h"
+#include "StreamEventSink.h"
+#include "ThreadPool.h"
+#include "TimingSink.h"
 
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include <algorithm>
 
 #define MThd 0x4d546864 // The string "MThd" in hexadecimal
 #define MTrk 0x4d54726b // The string "MTrk" in hexadecimal
 #define HEADER_SIZE 6   // The size of the MIDI header (always 6)
 
-#define DEFAULT_TEMPO 500000 // Five hundred thousand microseconds per quarter note or 120 bpm
+#define MAX_EVENT_HEADER 10 // Longest fixed part of an event: delta time, status, meta type and length
 
-#define VERIFY(x, msg) if (!(x)) { Error(msg); }
-#define ERROR(msg) Error(msg);
+#define VERIFY(x, code) if (!(x)) { Error({ code, reader.GetPosition(), -1, 0 }); }
+#define ERROR(code, offset) Error({ code, offset, -1, 0 });
+#define TRACK_ERROR(code, status) { error = { code, reader.GetPosition(), -1, (uint8_t)(status) }; return MidiEventStatus::Error; }
+
+// Only compact tracks limit their payloads (see CompactEvent::MaxPayloads)
+template<typename Track>
+static inline bool PayloadOverflow(const Track&) { return false; }
+static inline bool PayloadOverflow(const CompactTrack& track) { return track.GetPayloadCount() > CompactEvent::MaxPayloads; }
+template<typename Track>
+static inline bool PayloadOverflow(const FilterSink<Track>& sink) { return PayloadOverflow(sink.Target); }
 
 MidiParser::MidiParser(const std::string& file) {
     Open(file);
 }
 
 bool MidiParser::Open(const std::string& file) {
-    m_ReadPosition = 0;
-    m_TrackList.clear();
+    m_Stats = {};
+    MIDI_STATS_SCOPE(m_Stats);
+    MIDI_STATS_TIMER(OpenTime);
+
+    RecycleTracks();  // Lets go of the previous mapping, which the tracks keep alive
 
-    std::fstream input(file, std::ios_base::binary | std::ios_base::in);
-    if (!input) {
-        ERROR("Could not open file " + file);
+    // Keeps the previous mapping alive if a copy of this parser still references it
+    if (!m_File || m_File.use_count() > 1)
+        m_File = std::make_shared<MappedFile>();
+
+    if (!m_File->Open(file)) {
+        m_File.reset();
+        Reset(nullptr, 0);
+        ERROR(MidiErrorCode::CouldNotOpenFile, 0);
         return false;
     }
 
-    input.seekg(0, input.end);
-    size_t size = input.tellg();
-    input.seekg(0, input.beg);
+    return ParseBuffer(m_File->Data(), m_File->Size());
+}
 
-    if (size > m_Data.size())
-        m_Data.resize(size);
+bool MidiParser::Open(const uint8_t* data, size_t size) {
+    m_Stats = {};
+    MIDI_STATS_SCOPE(m_Stats);
+    MIDI_STATS_TIMER(OpenTime);
 
-    input.read((char*)m_Data.data(), size);
-    input.close();
+    m_File.reset();
 
+    return ParseBuffer(data, size);
+}
+
+bool MidiParser::ParseBuffer(const uint8_t* data, size_t size) {
+    Reset(data, size);
+    MIDI_STATS_COUNT(FileBytes, size);
     ReadFile();
 
+    // Nothing of a file that failed is kept, only why it failed
+    if (!m_ErrorStatus) {
+        ClearFile();
+        m_File.reset();
+    }
+
     return m_ErrorStatus;
 }
 
+void MidiParser::Reset(const uint8_t* data, size_t size) {
+    ClearFile();
+    m_Data = data;
+    m_Size = size;
+
+    m_ErrorStatus = true;
+    m_Error = {};
+    m_Errors.clear();
+}
+
+void MidiParser::ClearFile() {
+    m_Data = nullptr;
+    m_Size = 0;
+    RecycleTracks();
+
+    m_Chunks.clear();
+    m_Format = 0;
+    m_TrackCount = 0;
+    m_Division = 0;
+    m_TotalTicks = 0;
+    m_Duration = 0;
+    m_TempoMap.Clear();
+    m_TrackDecoded.clear();
+    m_PendingTracks = 0;
+    m_TimingRead = true;
+    m_TrackErrors.clear();
+}
+
+void MidiParser::RecycleTracks() {
+    // The spares are a stack taken from the back, so the tracks go in last first:
+    // track i of the next file then gets the buffers that were sized for track i
+    m_SpareTracks.reserve(m_SpareTracks.size() + m_TrackList.size());
+    for (auto track = m_TrackList.rbegin(); track != m_TrackList.rend(); track++) {
+        // An arena still shared with a copy of the track has to stay untouched
+        if (track->m_Payloads && track->m_Payloads.use_count() > 1)
+            track->m_Payloads.reset();
+
+        track->Clear();
+        track->m_Source.reset();
+        m_SpareTracks.push_back(std::move(*track));
+    }
+
+    m_SpareCompactTracks.reserve(m_SpareCompactTracks.size() + m_CompactTrackList.size());
+    for (auto track = m_CompactTrackList.rbegin(); track != m_CompactTrackList.rend(); track++) {
+        track->Clear();
+        track->m_Source.reset();
+        track->m_SourceData = nullptr;
+        m_SpareCompactTracks.push_back(std::move(*track));
+    }
+
+    m_TrackList.clear();
+    m_CompactTrackList.clear();
+}
+
+template<typename Track>
+void MidiParser::TakeTracks(std::vector<Track>& trackList, size_t count) {
+    std::vector<Track>* spares;
+    if constexpr (std::is_same_v<Track, MidiTrack>)
+        spares = &m_SpareTracks;
+    else
+        spares = &m_SpareCompactTracks;
+
+    trackList.reserve(count);
+    while (trackList.size() < count && !spares->empty()) {
+        trackList.push_back(std::move(spares->back()));
+        spares->pop_back();
+    }
+
+    trackList.resize(count);
+    spares->reserve(spares->size() + count);  // Room to recycle these tracks without allocating then
+}
+
 std::pair<uint32_t, uint32_t> MidiParser::GetDurationMinutesAndSeconds() {
+    ReadTiming();
     return { (uint32_t)(m_Duration / 1000000 / 60), (uint32_t)(m_Duration / 1000000 % 60) };
 }
 
 bool MidiParser::ReadFile() {
-    uint32_t mthd = ReadInteger();
-    uint32_t headerSize = ReadInteger();
-    m_Format = ReadShort();
-    m_TrackCount = ReadShort();
-    m_Division = ReadShort();
+    MIDI_STATS_TIMER(ReadFileTime);
 
-    VERIFY(mthd == MThd, "Invalid MIDI header: expected string \"MThd\"");
-    VERIFY(headerSize == HEADER_SIZE, "Invalid MIDI header: header size is not 6");
-    VERIFY(m_Format < 3, "Invalid MIDI header: invalid MIDI format");
-    VERIFY(m_Division != 0, "Invalid MIDI header: division is 0");
+    if (m_Size < HEADER_SIZE + 8) {
+        ERROR(MidiErrorCode::FileTooSmall, 0);
+        return false;
+    }
 
-    VERIFY(!(m_Division & 0x8000), "Division mode not supported");  // Checks if the left-most bit is not 1
-    VERIFY(m_Format != 2, "Type 2 MIDI format not supported");
+    ByteReader reader(m_Data, m_Size);
 
-    return m_ErrorStatus;
+    uint32_t mthd = reader.ReadInteger();
+    uint32_t headerSize = reader.ReadInteger();
+    m_Format = reader.ReadShort();
+    m_TrackCount = reader.ReadShort();
+    m_Division = reader.ReadShort();
+
+    VERIFY(mthd == MThd, MidiErrorCode::InvalidHeaderChunk);
+    VERIFY(headerSize == HEADER_SIZE, MidiErrorCode::InvalidHeaderSize);
+    VERIFY(m_Format < 3, MidiErrorCode::InvalidFormat);
+    VERIFY(m_Division != 0, MidiErrorCode::InvalidDivision);
+
+    VERIFY(!(m_Division & 0x8000), MidiErrorCode::UnsupportedDivision);  // Checks if the left-most bit is not 1
+    VERIFY(m_Format != 2, MidiErrorCode::UnsupportedFormat);
 
     if (!m_ErrorStatus)
         return false;
 
-    m_TrackList.reserve(m_TrackCount);  // Reserves memory
+    if (!ScanChunks(reader))
+        return false;
+
+    if (m_Options.Lazy) {
+        // Empty until first accessed
+        if (m_Options.Storage == TrackStorage::Compact)
+            TakeTracks(m_CompactTrackList, m_Chunks.size());
+        else
+            TakeTracks(m_TrackList, m_Chunks.size());
+
+        m_TrackDecoded.assign(m_Chunks.size(), false);
+        m_TrackErrors.assign(m_Chunks.size(), {});
+        m_PendingTracks = m_Chunks.size();
+        m_TimingRead = false;
+        return m_ErrorStatus;
+    }
 
     // This parses the tracks
-    for (int i = 0; i < m_TrackCount; i++)
-        if (!ReadTrack())
-            break;
+    if (m_Options.Storage == TrackStorage::Compact) {
+        ReadTracks(m_CompactTrackList);
+        BuildTempoMap(m_CompactTrackList);
+    } else {
+        ReadTracks(m_TrackList);
+        BuildTempoMap(m_TrackList);
+    }
 
     return m_ErrorStatus;
 }
 
-bool MidiParser::ReadTrack() {
-    VERIFY(ReadInteger() == MTrk, "Invalid track: expected string \"MTrk\"");
+bool MidiParser::ScanChunks(ByteReader& reader) {
+    MIDI_STATS_TIMER(ScanChunksTime);
 
-    uint32_t size = ReadInteger();  // Size of track chunk in bytes
-    MidiTrack& track = m_TrackList.emplace_back(size * 8);  // 8 is a good number I guess
+    m_Chunks.clear();
+    m_Chunks.reserve(m_TrackCount);
 
-    if (m_ReadPosition + size > m_Data.size()) {
-        ERROR("Invalid track size");
-        return false;
+    while (m_Chunks.size() < m_TrackCount) {
+        if (reader.Remaining() < 8) {
+            ERROR(MidiErrorCode::MissingTrackChunk, reader.GetPosition());
+            return false;
+        }
+
+        uint32_t type = reader.ReadInteger();
+        uint32_t size = reader.ReadInteger();  // Size of track chunk in bytes
+
+        if (size > reader.Remaining()) {
+            if (!m_Options.Lenient || type != MTrk) {
+                ERROR(MidiErrorCode::InvalidTrackSize, reader.GetPosition() - 4);
+                return false;
+            }
+
+            // The length is wrong, so the track runs until the next track chunk (or the end of the file)
+            Report({ MidiErrorCode::InvalidTrackSize, reader.GetPosition() - 4, (int32_t)m_Chunks.size(), 0 });
+            size = (uint32_t)Simd::FindTag(reader.Current(), reader.Remaining(), MTrk);
+        }
+
+        // Chunks of an unknown type must be skipped
+        if (type == MTrk)
+            m_Chunks.push_back({ reader.GetPosition(), size });
+
+        reader.Skip(size);
     }
 
-    MidiEventType runningStatus = MidiEventType::None;
+    return true;
+}
+
+template<typename Track>
+void MidiParser::PrepareTrack(Track& track) const {
+    if constexpr (std::is_same_v<Track, MidiTrack>) {
+        // A recycled track keeps its arena unless a copy of the parser shares it
+        if (!track.m_Payloads || track.m_Payloads.use_count() > 1)
+            track.m_Payloads = std::make_shared<PayloadArena>();
+    } else {
+        track.m_SourceData = m_Data;
+    }
 
-    // Reads each event in the track
-    for (MidiEventStatus s = MidiEventStatus::Success; s == MidiEventStatus::Success; )
-        s = ReadEvent(track, runningStatus);
+    // SysEx events point into the source, which the tracks keep alive if it is a mapped file
+    track.m_Source = m_File;
+}
 
-    // Sets the duration of the MIDI file in ticks
-    if (track.m_TotalTicks > m_TotalTicks)
-        m_TotalTicks = track.m_TotalTicks;
+template<typename Track>
+void MidiParser::ReadTracks(std::vector<Track>& trackList) {
+    MIDI_STATS_TIMER(ReadTracksTime);
 
-    return m_ErrorStatus;
+    size_t trackCount = m_Chunks.size();
+    TakeTracks(trackList, trackCount);
+
+    for (size_t i = 0; i < trackCount; i++)
+        PrepareTrack(trackList[i]);
+
+    std::vector<MidiError>& errors = m_TrackErrors;
+    errors.assign(trackCount, {});
+
+    // Tracks in a format 1 file are independent of each other
+    bool parallel = m_Format == 1 && trackCount > 1 && m_Options.Threads != 1;
+    if (parallel) {
+        if (!m_ThreadPool || m_ThreadPool->GetThreadCount() != ThreadCount())
+            m_ThreadPool = std::make_shared<ThreadPool>(ThreadCount());
+
+        // Each track counts into its own stats, which are added up afterwards
+        MIDI_STATS(std::vector<ParseStats> trackStats(trackCount));
+
+        m_ThreadPool->ParallelFor(trackCount, [&](size_t i) {
+            MIDI_STATS_SCOPE(trackStats[i]);
+            ReadTrack(trackList[i], m_Chunks[i], errors[i]);
+        });
+
+        MIDI_STATS(for (const ParseStats& stats : trackStats) m_Stats += stats);
+    } else {
+        for (size_t i = 0; i < trackCount; i++)
+            if (!ReadTrack(trackList[i], m_Chunks[i], errors[i]) && !m_Options.Lenient)
+                break;
+    }
+
+    // Merged in track order so the result does not depend on scheduling
+    for (size_t i = 0; i < trackCount; i++) {
+        if (errors[i]) {
+            errors[i].Track = (int32_t)i;
+
+            if (!m_Options.Lenient) {
+                Error(errors[i]);
+                break;
+            }
+
+            // The events read before the error cannot be trusted either
+            Report(errors[i]);
+            trackList[i].Clear();
+            continue;
+        }
+
+        // Sets the duration of the MIDI file in ticks
+        if (trackList[i].m_TotalTicks > m_TotalTicks)
+            m_TotalTicks = trackList[i].m_TotalTicks;
+    }
 }
 
-MidiParser::MidiEventStatus MidiParser::ReadEvent(MidiTrack& track, MidiEventType& runningStatus) {
-    uint32_t deltaTime = ReadVariableLengthValue();  // Ticks since last event
-    MidiEventType eventType = (MidiEventType)ReadByte();
-    EventCategory eventCategory = eventType >= 0xf0 ? (EventCategory)eventType : EventCategory::Midi;
+template<typename Track>
+bool MidiParser::ReadTrack(Track& track, const TrackChunk& chunk, MidiError& error) const {
+    MIDI_STATS_TIMER(ReadTrackTime);
+    MIDI_STATS_COUNT(Tracks, 1);
+    MIDI_STATS_COUNT(TrackBytes, chunk.Size);
+
+    bool filtered = !m_Options.Filter.AcceptsAll();
+
+    // A recycled track reuses its buffers, which only grow if this track is larger
+    if constexpr (std::is_same_v<Track, CompactTrack>) {
+        // Growing 8 byte records costs less than counting them first
+        if (track.m_Events.capacity() == 0 && !filtered)
+            track.Reserve(chunk.Size / 3, 0, 0);  // Channel events are about 3 bytes in the file
+    } else if (track.m_Capacity == 0 && !filtered) {
+        // A new track is counted first so its storage is allocated once, at its exact size
+        MIDI_STATS_TIMER(CountTime);
+
+        EventCounts counts;
+        if (CountEvents(m_Data + chunk.Offset, chunk.Size, counts)) {
+            track.Reserve(counts.MidiEvents, counts.MetaEvents, counts.SysExEvents);
+            if (counts.MetaBytes > 0)
+                track.m_Payloads->Reserve(counts.MetaBytes);
+        }
+    }
+
+    if (!filtered)
+        return ReadEvents(track, chunk, error);
+
+    FilterSink<Track> sink(track, m_Options.Filter);
+    bool success = ReadEvents(sink, chunk, error);
+    track.m_TotalTicks = sink.m_TotalTicks;
+
+    return success;
+}
+
+template<typename Track>
+bool MidiParser::ReadEvents(Track& track, const TrackChunk& chunk, MidiError& error) const {
+    // ScanChunks made sure the chunk lies inside the file, so the reader only has to stay inside the chunk
+    ByteReader reader(m_Data, chunk.Offset + chunk.Size, chunk.Offset);
+    TrackState state;
+
+    // Reads each event in the track. While a whole event header fits in the
+    // chunk the reads cannot leave it, so only the last few events are checked.
+    MidiEventStatus s = MidiEventStatus::Success;
+    while (s == MidiEventStatus::Success && reader.Remaining() >= MAX_EVENT_HEADER)
+        s = ReadEvent<false, true>(track, reader, state, error);
+    while (s == MidiEventStatus::Success && reader.Remaining() > 0)
+        s = ReadEvent<true, false>(track, reader, state, error);
+
+    return s != MidiEventStatus::Error;
+}
+
+template<bool Checked, bool Padded, typename Track>
+MidiParser::MidiEventStatus MidiParser::ReadEvent(Track& track, ByteReader& reader, TrackState& state, MidiError& error) {
+    int32_t deltaTime = reader.ReadVariableLengthValue<Checked, Padded>();  // Ticks since last event
+    uint8_t byte = reader.ReadByte<Checked>();
+
+    if constexpr (Checked)
+        if (reader.Overrun())
+            TRACK_ERROR(MidiErrorCode::EventOutOfBounds, 0);
+    if (deltaTime < 0)
+        TRACK_ERROR(MidiErrorCode::InvalidVariableLength, 0);
     track.m_TotalTicks += deltaTime;
 
-    if (eventCategory == EventCategory::Meta) {  // Meta event
-        runningStatus = MidiEventType::None;
+    // A data byte in place of the status byte repeats the last channel status
+    bool running = byte < 0x80;
+    uint8_t status = running ? (uint8_t)state.RunningStatus : byte;
+    StatusInfo info = StatusTable[status];
+
+    if (info.Kind == StatusKind::Channel) {  // Midi event
+        MIDI_STATS_COUNT(MidiEvents, 1);
+        MIDI_STATS_COUNT(RunningStatusEvents, running);
+        state.RunningStatus = (MidiEventType)status;
+
+        // These branch: computing the length without branches makes the next event wait for this
+        // status byte to load, which is slower on real files where the branches are predicted
+        uint8_t a = running ? byte : reader.ReadByte<Checked>();
+        uint8_t b = info.DataBytes == 2 ? reader.ReadByte<Checked>() : 0;
+
+        if constexpr (Checked)
+            if (reader.Overrun())
+                TRACK_ERROR(MidiErrorCode::EventOutOfBounds, status);
+
+        MidiEventType eventType = (MidiEventType)(status & 0xf0);
+        if (eventType == MidiEventType::NoteOn && b == 0)
+            eventType = MidiEventType::NoteOff;
+
+        track.AppendMidiEvent(track.m_TotalTicks, eventType, status & 0x0f, a, b);
+
+        return MidiEventStatus::Success;
+    } else if (info.Kind == StatusKind::Meta) {  // Meta event
+        MIDI_STATS_COUNT(MetaEvents, 1);
+        state.RunningStatus = MidiEventType::None;
 
-        MetaEventType metaType = (MetaEventType)ReadByte();
-        int32_t metaLength = ReadVariableLengthValue();
+        MetaEventType metaType = (MetaEventType)reader.ReadByte<Checked>();
+        int32_t metaLength = reader.ReadVariableLengthValue<Checked, Padded>();
+
+        if constexpr (Checked)
+            if (reader.Overrun())
+                TRACK_ERROR(MidiErrorCode::EventOutOfBounds, status);
+        if (metaLength < 0)
+            TRACK_ERROR(MidiErrorCode::InvalidVariableLength, status);
+        if ((size_t)metaLength > reader.Remaining())  // One check per payload, not per byte
+            TRACK_ERROR(MidiErrorCode::PayloadOutOfBounds, status);
 
         if (metaType == MetaEventType::EndOfTrack)
             return MidiEventStatus::End;
 
-        std::vector<uint8_t> data(metaLength);
-        ReadBytes(data.data(), metaLength);
+        track.AppendMetaEvent(track.m_TotalTicks, metaType, reader.Current(), metaLength);
+        reader.Skip(metaLength);
 
-        track.AppendEvent<MetaEvent>(track.m_TotalTicks, 0.0f, metaType, std::move(data));
+        if (PayloadOverflow(track))  // Its index has wrapped around
+            TRACK_ERROR(MidiErrorCode::TooManyPayloads, status);
 
         return MidiEventStatus::Success;
-    } else if (eventCategory == EventCategory::SysEx) {  // Ignore SysEx events
-        runningStatus = MidiEventType::None;
-
-        ERROR("SysEx events not supported yet");
-        return MidiEventStatus::Error;
-    } else {  // Midi event
-        uint8_t a, b;
-        if (eventType < 0x80) {
-            a = eventType;
-            eventType = runningStatus;
-        } else {
-            runningStatus = eventType;
-            a = ReadByte();
-        }
+    } else if (info.Kind == StatusKind::SysEx) {  // SysEx event
+        MIDI_STATS_COUNT(SysExEvents, 1);
+        state.RunningStatus = MidiEventType::None;
 
-        uint8_t channel = eventType & 0x0f;
+        int32_t length = reader.ReadVariableLengthValue<Checked, Padded>();
 
-        switch (eventType - channel) {
-            // These have 2 bytes of data
-            case MidiEventType::NoteOn:
-            {
-                b = ReadByte();
-                if (b == 0)
-                    eventType = MidiEventType::NoteOff;
-                break;
-            }
-            case MidiEventType::NoteOff:
-            case MidiEventType::PolyAfter:
-            case MidiEventType::ControlChange:
-            case MidiEventType::PitchBend:
-            {
-                b = ReadByte();
-                break;
-            }
-            // These have 1 byte of data
-            case MidiEventType::ProgramChange:
-            case MidiEventType::ChannelAfterTouch:
-            {
-                break;
-            }
-            // Error
-            default:
-            {
-                std::ostringstream ss;
-                ss << "Unrecognized event type: " << std::hex << "0x" << (int)eventType;
-                ERROR(ss.str());
-                return MidiEventStatus::Error;
-            }
-        }
+        if constexpr (Checked)
+            if (reader.Overrun())
+                TRACK_ERROR(MidiErrorCode::EventOutOfBounds, status);
+        if (length < 0)
+            TRACK_ERROR(MidiErrorCode::InvalidVariableLength, status);
+        if ((size_t)length > reader.Remaining())
+            TRACK_ERROR(MidiErrorCode::PayloadOutOfBounds, status);
+
+        const uint8_t* data = reader.Current();
+        bool closed = length > 0 && data[length - 1] == 0xf7;  // The message ends in this packet
 
-        track.AppendEvent<MidiEvent>(track.m_TotalTicks, 0.0f, eventType, channel, a, b);
+        SysExPacket packet;
+        if (info.Category == EventCategory::SysEx)
+            packet = closed ? SysExPacket::Complete : SysExPacket::First;
+        else if (state.SysExPending)
+            packet = closed ? SysExPacket::Last : SysExPacket::Continuation;
+        else
+            packet = SysExPacket::Escape;
+
+        if (packet != SysExPacket::Escape)
+            state.SysExPending = !closed;
+
+        track.AppendSysExEvent(track.m_TotalTicks, info.Category, packet, data, length);
+        reader.Skip(length);
+
+        if (PayloadOverflow(track))
+            TRACK_ERROR(MidiErrorCode::TooManyPayloads, status);
 
         return MidiEventStatus::Success;
+    } else if (running) {
+        TRACK_ERROR(MidiErrorCode::MissingRunningStatus, byte);
+    } else {
+        TRACK_ERROR(MidiErrorCode::UnrecognizedEvent, status);
     }
+}
 
-    return MidiEventStatus::Error;
+// Used by MidiCache to fill tracks it loads
+template void MidiParser::PrepareTrack<MidiTrack>(MidiTrack&) const;
+
+// Used by MidiStreamParser to decode one event at a time
+template MidiParser::MidiEventStatus MidiParser::ReadEvent<false, false, StreamEventSink>(StreamEventSink&, ByteReader&, TrackState&, MidiError&);
+
+inline unsigned MidiParser::ThreadCount() const {
+    if (m_Options.Threads == 0)
+        return std::max(1u, std::thread::hardware_concurrency());
+    return m_Options.Threads;
 }
 
-inline int32_t MidiParser::ReadVariableLengthValue() {
-    int32_t value = 0;
+template<typename Track>
+void MidiParser::BuildTempoMap(std::vector<Track>& trackList) {
+    MIDI_STATS_TIMER(TempoMapTime);
+
+    std::vector<TempoChange> changes = m_TempoMap.ReleaseChanges();  // Reuses the previous file's storage
+    changes.clear();
+
+    // Tempo events normally live in the first track, but any track may have them
+    for (Track& track : trackList) {
+        if constexpr (std::is_same_v<Track, CompactTrack>) {
+            for (const CompactEvent& event : track) {
+                if (event.Category != EventCategory::Meta)
+                    continue;
 
-    for (int i = 0; i < 16; i++) {
-        uint8_t byte = ReadByte();
-        value += (byte & 0b01111111);
-        if (!(byte & 0b10000000))  // If the left bit is 0 (end of value)
-            return value;
-        value <<= 7;
+                CompactMetaEvent metaEvent = track.GetMetaEvent(event);
+                if (metaEvent.Type == MetaEventType::Tempo)
+                    AddTempoChange(changes, metaEvent.Tick, metaEvent.Data, metaEvent.Size);
+            }
+        } else {
+            for (size_t i = 0; i < track.GetEventCount(); i++) {
+                Event* event = track[i];
+                if (event->GetCategory() == EventCategory::Meta && event->GetType() == MetaEventType::Tempo) {
+                    MetaEvent* metaEvent = (MetaEvent*)event;
+                    AddTempoChange(changes, metaEvent->GetTick(), metaEvent->Data(), metaEvent->GetSize());
+                }
+            }
+        }
     }
 
-    ERROR("Unable to read variable length value");
-    return -1;
+    m_TempoMap.Build(m_Division, std::move(changes));
+    m_Duration = m_TempoMap.TicksToMicroseconds(m_TotalTicks);
+
+    if constexpr (std::is_same_v<Track, MidiTrack>)
+        for (MidiTrack& track : trackList)
+            SetEventTimes(track);
 }
 
-inline uint8_t MidiParser::ReadByte() {
-    uint8_t number = *(uint8_t*)(m_Data.data() + m_ReadPosition);
-    m_ReadPosition += sizeof(uint8_t);
+// Events in a track are sorted by tick, so each track is one linear walk over the tempo changes
+void MidiParser::SetEventTimes(MidiTrack& track) const {
+    const std::vector<TempoChange>& tempoChanges = m_TempoMap.GetChanges();
+
+    size_t change = 0;
+    for (size_t i = 0; i < track.GetEventCount(); i++) {
+        Event* event = track[i];
+        while (change + 1 < tempoChanges.size() && tempoChanges[change + 1].Tick <= event->m_Tick)
+            change++;
 
-    return number;
+        event->m_Time = (float)m_TempoMap.TicksToMicroseconds(event->m_Tick, change);
+    }
 }
 
-inline uint16_t MidiParser::ReadShort() {
-    uint16_t number = *(uint16_t*)(m_Data.data() + m_ReadPosition);
-    m_ReadPosition += sizeof(uint16_t);
+void MidiParser::ReadTimingLazily() const {
+    MIDI_STATS_SCOPE(m_Stats);
+    MIDI_STATS_TIMER(TempoMapTime);
+
+    m_TimingRead = true;
+
+    std::vector<TempoChange> changes = m_TempoMap.ReleaseChanges();  // Reuses the previous file's storage
+    changes.clear();
+
+    for (const TrackChunk& chunk : m_Chunks) {
+        TimingSink sink(changes);
+        size_t changeCount = changes.size();
+
+        // A broken track is reported when it is decoded, and decodes to nothing
+        MidiError error;
+        if (!ReadEvents(sink, chunk, error)) {
+            changes.resize(changeCount);
+            continue;
+        }
+
+        if (sink.m_TotalTicks > m_TotalTicks)
+            m_TotalTicks = sink.m_TotalTicks;
+    }
+
+    m_TempoMap.Build(m_Division, std::move(changes));
+    m_Duration = m_TempoMap.TicksToMicroseconds(m_TotalTicks);
+}
 
-    if constexpr (Endian::Little)
-        number = Endian::FlipEndian(number);
+void MidiParser::DecodeTrackLazily(size_t index) const {
+    if (m_Options.Storage == TrackStorage::Compact)
+        DecodeTrackLazily(m_CompactTrackList, index);
+    else
+        DecodeTrackLazily(m_TrackList, index);
+}
 
-    return number;
+void MidiParser::DecodeTracksLazily() const {
+    for (size_t i = 0; i < m_TrackDecoded.size(); i++)
+        DecodeTrack(i);
 }
 
-inline uint32_t MidiParser::ReadInteger() {
-    uint32_t number = *(uint32_t*)(m_Data.data() + m_ReadPosition);
-    m_ReadPosition += sizeof(uint32_t);
+template<typename Track>
+void MidiParser::DecodeTrackLazily(std::vector<Track>& trackList, size_t index) const {
+    ReadTiming();  // Event times need the tempo map
+
+    MIDI_STATS_SCOPE(m_Stats);
+
+    m_TrackDecoded[index] = true;
+    m_PendingTracks--;
+
+    Track& track = trackList[index];
+    PrepareTrack(track);
 
-    if constexpr (Endian::Little)
-        number = Endian::FlipEndian(number);
+    // Open has already succeeded, so a broken track is left empty in either mode
+    MidiError& error = m_TrackErrors[index];
+    if (!ReadTrack(track, m_Chunks[index], error)) {
+        error.Track = (int32_t)index;
+        Report(error);
+        track.Clear();
+    }
+
+    if constexpr (std::is_same_v<Track, MidiTrack>)
+        SetEventTimes(track);
+}
 
-    return number;
+MidiError MidiParser::GetTrackError(size_t index) const {
+    DecodeTrack(index);
+    return index < m_TrackErrors.size() ? m_TrackErrors[index] : MidiError();  // Tracks loaded from a cache have none
 }
 
-inline void MidiParser::ReadBytes(uint8_t* buffer, size_t size) {
-    std::copy(m_Data.data() + m_ReadPosition, m_Data.data() + m_ReadPosition + size, buffer);
-    m_ReadPosition += size;
+std::string MidiParser::GetTrackName(size_t index) const {
+    if (index >= m_Chunks.size() || m_Data == nullptr)
+        return std::string();
+
+    const TrackChunk& chunk = m_Chunks[index];
+    ByteReader reader(m_Data, chunk.Offset + chunk.Size, chunk.Offset);
+    TrackState state;
+    StreamEventSink event;
+    MidiError error;
+
+    // Names come before the first channel event
+    while (reader.Remaining() > 0 && ReadEvent<true, false>(event, reader, state, error) == MidiEventStatus::Success) {
+        if (event.Category == EventCategory::Midi)
+            break;
+        if (event.Category == EventCategory::Meta && event.Type == MetaEventType::TrackName)
+            return std::string((const char*)event.Data, event.Size);
+    }
+
+    return std::string();
 }
 
-inline float MidiParser::TicksToMicroseconds(uint32_t ticks, uint32_t tempo) {
-    return ticks / (float)m_Division * tempo;
+void MidiParser::Report(const MidiError& error) const {
+    m_Errors.push_back(error);
+    if (m_Options.OnError)
+        m_Options.OnError(error);
 }
 
-void MidiParser::Error(const std::string& msg) {
-    std::cout << "Error: " << msg << "\n";
+void MidiParser::Error(const MidiError& error) const {
+    Report(error);
+    m_Error = error;
     m_ErrorStatus = false;
 }
@@ -0,0 +1,215 @@
+#include "MidiSequencer.h"
+#include "MidiParser.h"
+
+#include <cmath>
+
+MidiSequencer::MidiSequencer(const MidiParser& parser, size_t queueCapacity)
+    : m_Parser(&parser), m_TempoMap(&parser.GetTempoMap()), m_Compact(parser.GetOptions().Storage == TrackStorage::Compact), m_Queue(queueCapacity) {
+
+    if (m_Compact)
+        m_CompactEvents = MergedCompactEvents(parser.GetCompactTracks());
+    else
+        m_Events = MergedEvents(parser.GetTracks());
+}
+
+void MidiSequencer::Start(uint64_t now) {
+    Rebase(now, IsEnd() ? 0 : CurrentTick());
+}
+
+void MidiSequencer::Seek(uint32_t tick, uint64_t now) {
+    SeekView(tick);
+    Rebase(now, tick);
+
+    // Pop compares against this before handing out an event
+    m_CurrentGeneration.store(++m_Generation, std::memory_order_release);
+}
+
+void MidiSequencer::SetSpeed(double speed, uint64_t now) {
+    if (!(speed > 0.0))
+        return;
+
+    // Keeps the song position at now where it is, then plays on at the new speed
+    uint64_t songTime = m_OriginSongTime;
+    if (now > m_OriginTime)
+        songTime += (uint64_t)std::llround((now - m_OriginTime) * m_Speed);
+
+    m_OriginTime = now;
+    m_OriginSongTime = songTime;
+    m_Speed = speed;
+}
+
+void MidiSequencer::SetLoop(uint32_t startTick, uint32_t endTick) {
+    m_Loop = endTick > startTick;
+    m_LoopStart = startTick;
+    m_LoopEnd = endTick;
+}
+
+void MidiSequencer::ClearLoop() {
+    m_Loop = false;
+}
+
+size_t MidiSequencer::Update(uint64_t now) {
+    uint64_t limit = now + m_LookAhead;
+    size_t queued = 0;
+
+    for (;;) {
+        // The loop end is reached even if no event sits exactly on it
+        if (m_Loop && (IsEnd() || CurrentTick() >= m_LoopEnd)) {
+            uint64_t loopTime = OutputTime(m_LoopEnd);
+            if (loopTime > limit)
+                break;
+
+            SeekView(m_LoopStart);
+            Rebase(loopTime, m_LoopStart);
+            continue;
+        }
+
+        if (IsEnd())
+            break;
+
+        uint32_t tick = CurrentTick();
+        uint64_t time = OutputTime(tick);
+        if (time > limit)
+            break;
+
+        SequencedEvent event;
+        CurrentEvent(event);
+        event.Time = time;
+        event.Generation = m_Generation;
+
+        if (!m_Queue.Push(event))
+            break;  // The consumer is behind; the event is queued by a later Update
+
+        Advance();
+        queued++;
+    }
+
+    return queued;
+}
+
+uint32_t MidiSequencer::GetPositionTick() const {
+    return IsEnd() ? (uint32_t)m_Parser->GetTotalTicks() : CurrentTick();
+}
+
+bool MidiSequencer::IsFinished() const {
+    return !m_Loop && IsEnd();
+}
+
+// The generation is read again for every event: Seek publishes it before its
+// events are pushed, so a seek made while draining is seen by the time its
+// events are, instead of them being dropped as stale
+bool MidiSequencer::Pop(SequencedEvent& event) {
+    while (m_Queue.Pop(event)) {
+        if (event.Generation == m_CurrentGeneration.load(std::memory_order_acquire))
+            return true;
+    }
+
+    return false;
+}
+
+bool MidiSequencer::PopDue(SequencedEvent& event, uint64_t now) {
+    while (const SequencedEvent* front = m_Queue.Front()) {
+        if (front->Generation != m_CurrentGeneration.load(std::memory_order_acquire)) {
+            m_Queue.Pop();  // Queued before a seek
+            continue;
+        }
+
+        if (front->Time > now)
+            return false;
+
+        event = *front;
+        m_Queue.Pop();
+        return true;
+    }
+
+    return false;
+}
+
+inline uint64_t MidiSequencer::OutputTime(uint32_t tick) const {
+    uint64_t songTime = m_TempoMap->TicksToMicroseconds(tick);
+    if (songTime <= m_OriginSongTime)
+        return m_OriginTime;
+
+    return m_OriginTime + (uint64_t)std::llround((songTime - m_OriginSongTime) / m_Speed);
+}
+
+inline void MidiSequencer::Rebase(uint64_t outputTime, uint32_t tick) {
+    m_OriginTime = outputTime;
+    m_OriginSongTime = m_TempoMap->TicksToMicroseconds(tick);
+}
+
+inline bool MidiSequencer::IsEnd() const {
+    return m_Compact ? m_CompactEvents.IsEnd() : m_Events.IsEnd();
+}
+
+inline uint32_t MidiSequencer::CurrentTick() const {
+    return m_Compact ? m_CompactEvents.CurrentTick() : m_Events.CurrentTick();
+}
+
+void MidiSequencer::CurrentEvent(SequencedEvent& event) const {
+    event.Data = nullptr;
+    event.Size = 0;
+    event.Channel = event.DataA = event.DataB = 0;
+
+    if (m_Compact) {
+        const CompactTrack& track = m_Parser->GetCompactTrack(m_CompactEvents.CurrentTrack());
+        const CompactEvent& compactEvent = m_CompactEvents.CurrentEvent();
+
+        event.Tick = compactEvent.Tick;
+        event.Track = m_CompactEvents.CurrentTrack();
+        event.Category = compactEvent.Category;
+
+        if (compactEvent.IsMidi()) {
+            event.Type = compactEvent.GetMidiType();
+            event.Channel = compactEvent.GetChannel();
+            event.DataA = compactEvent.GetDataA();
+            event.DataB = compactEvent.GetDataB();
+        } else if (compactEvent.Category == EventCategory::Meta) {
+            CompactMetaEvent metaEvent = track.GetMetaEvent(compactEvent);
+            event.Type = metaEvent.Type;
+            event.Data = metaEvent.Data;
+            event.Size = metaEvent.Size;
+        } else {
+            CompactSysExEvent sysExEvent = track.GetSysExEvent(compactEvent);
+            event.Type = (uint8_t)sysExEvent.Category;
+            event.Data = sysExEvent.Data;
+            event.Size = sysExEvent.Size;
+        }
+    } else {
+        const Event* source = m_Events.CurrentEvent();
+
+        event.Tick = source->GetTick();
+        event.Track = m_Events.CurrentTrack();
+        event.Category = source->GetCategory();
+        event.Type = source->GetType();
+
+        if (event.Category == EventCategory::Midi) {
+            const MidiEvent* midiEvent = static_cast<const MidiEvent*>(source);
+            event.Channel = midiEvent->GetChannel();
+            event.DataA = midiEvent->GetDataA();
+            event.DataB = midiEvent->GetDataB();
+        } else if (event.Category == EventCategory::Meta) {
+            const MetaEvent* metaEvent = static_cast<const MetaEvent*>(source);
+            event.Data = metaEvent->Data();
+            event.Size = (uint32_t)metaEvent->GetSize();
+        } else {
+            const SysExEvent* sysExEvent = static_cast<const SysExEvent*>(source);
+            event.Data = sysExEvent->Data();
+            event.Size = (uint32_t)sysExEvent->GetSize();
+        }
+    }
+}
+
+void MidiSequencer::Advance() {
+    if (m_Compact)
+        m_CompactEvents.Advance();
+    else
+        m_Events.Advance();
+}
+
+void MidiSequencer::SeekView(uint32_t tick) {
+    if (m_Compact)
+        m_CompactEvents.Seek(tick);
+    else
+        m_Events.Seek(tick);
+}
@@ -0,0 +1,284 @@
+#include "MidiStreamParser.h"
+#include "ByteReader.h"
+#include "MidiParser.h"
+#include "StreamEventSink.h"
+
+#define MThd 0x4d546864 // The string "MThd" in hexadecimal
+#define MTrk 0x4d54726b // The string "MTrk" in hexadecimal
+#define HEADER_SIZE 6   // The size of the MIDI header (always 6)
+
+#define INCOMPLETE 0
+#define INVALID SIZE_MAX  // A variable length value is longer than 4 bytes
+#define NO_STATUS (SIZE_MAX - 1)  // A data byte without a running status
+
+// Reads a variable length value without going past size. Returns false if more bytes are needed.
+static inline bool MeasureVariableLengthValue(const uint8_t* data, size_t size, size_t& position, uint32_t& value, bool& invalid) {
+    value = 0;
+
+    for (int i = 0; i < 4; i++) {
+        if (position >= size)
+            return false;
+
+        uint8_t byte = data[position++];
+        value = (value << 7) | (byte & 0b01111111);
+        if (!(byte & 0b10000000))
+            return true;
+    }
+
+    invalid = true;
+    return false;
+}
+
+// Size in bytes of the event at data, INCOMPLETE if it does not fit in size yet.
+// Sets needed to the size of an incomplete meta or SysEx event once its length has been read.
+static size_t MeasureEvent(const uint8_t* data, size_t size, MidiEventType runningStatus, size_t& needed) {
+    size_t position = 0;
+    uint32_t value = 0;
+    bool invalid = false;
+
+    if (!MeasureVariableLengthValue(data, size, position, value, invalid))  // Delta time
+        return invalid ? INVALID : INCOMPLETE;
+
+    if (position >= size)
+        return INCOMPLETE;
+
+    uint8_t status = data[position];
+
+    if (status >= 0xf0) {  // Meta and SysEx events carry their own length
+        position += status == 0xff ? 2 : 1;
+        if (position > size)
+            return INCOMPLETE;
+
+        if (!MeasureVariableLengthValue(data, size, position, value, invalid))
+            return invalid ? INVALID : INCOMPLETE;
+
+        needed = position + value;
+        return needed <= size ? needed : INCOMPLETE;
+    }
+
+    uint8_t eventType = status;
+    if (status < 0x80) {  // Running status: the status byte is the first data byte
+        if (runningStatus == MidiEventType::None)
+            return NO_STATUS;
+        eventType = runningStatus;
+    } else {
+        position++;
+    }
+
+    switch (eventType & 0xf0) {
+        case MidiEventType::ProgramChange:
+        case MidiEventType::ChannelAfterTouch:
+            position += 1;
+            break;
+        default:
+            position += 2;
+            break;
+    }
+
+    return position <= size ? position : INCOMPLETE;
+}
+
+MidiStreamParser::MidiStreamParser(size_t maxBufferSize)
+    : m_MaxBufferSize(maxBufferSize) {}
+
+void MidiStreamParser::Reset() {
+    m_Buffer.clear();
+    m_BufferPosition = 0;
+    m_BytesConsumed = 0;
+    m_InputFinished = false;
+
+    m_State = State::Header;
+    m_Format = m_TrackCount = m_Division = 0;
+
+    m_TrackIndex = 0;
+    m_ChunkRemaining = 0;
+    m_Tick = 0;
+    m_RunningStatus = MidiEventType::None;
+    m_SysExPending = false;
+}
+
+bool MidiStreamParser::Feed(const uint8_t* data, size_t size) {
+    // Drops the bytes that were already decoded
+    if (m_BufferPosition > 0) {
+        m_Buffer.erase(m_Buffer.begin(), m_Buffer.begin() + m_BufferPosition);
+        m_BufferPosition = 0;
+    }
+
+    if (m_Buffer.size() + size > m_MaxBufferSize)
+        return false;
+
+    m_Buffer.insert(m_Buffer.end(), data, data + size);
+    return true;
+}
+
+MidiStreamParser::Status MidiStreamParser::Next(StreamEvent& event) {
+    for (;;) {
+        Status status;
+
+        switch (m_State) {
+            case State::Header:
+                status = ReadHeader();
+                break;
+            case State::ChunkHeader:
+                status = ReadChunkHeader();
+                break;
+            case State::SkipChunk:
+            {
+                size_t size = std::min<size_t>(Buffered(), m_ChunkRemaining);
+                Consume(size);
+                m_ChunkRemaining -= (uint32_t)size;
+
+                if (m_ChunkRemaining > 0)
+                    return m_InputFinished ? Fail(MidiErrorCode::InvalidTrackSize) : Status::NeedMoreData;
+
+                m_State = State::ChunkHeader;
+                continue;
+            }
+            case State::Events:
+                return ReadStreamEvent(event);
+            case State::End:
+                return Status::End;
+            default:
+                return Status::Error;
+        }
+
+        if (status != Status::Event)  // The header states report Event when they made progress
+            return status;
+    }
+}
+
+void MidiStreamParser::Consume(size_t size) {
+    m_BufferPosition += size;
+    m_BytesConsumed += size;
+}
+
+MidiStreamParser::Status MidiStreamParser::Fail(MidiErrorCode code, uint8_t status) {
+    int32_t track = m_State == State::Events ? m_TrackIndex - 1 : -1;
+    m_Error = { code, m_BytesConsumed, track, status };
+    m_State = State::Error;
+    return Status::Error;
+}
+
+MidiStreamParser::Status MidiStreamParser::ReadHeader() {
+    if (Buffered() < HEADER_SIZE + 8)
+        return m_InputFinished ? Fail(MidiErrorCode::FileTooSmall) : Status::NeedMoreData;
+
+    ByteReader reader(BufferData(), Buffered());
+    uint32_t mthd = reader.ReadInteger();
+    uint32_t headerSize = reader.ReadInteger();
+    m_Format = reader.ReadShort();
+    m_TrackCount = reader.ReadShort();
+    m_Division = reader.ReadShort();
+
+    if (mthd != MThd)
+        return Fail(MidiErrorCode::InvalidHeaderChunk);
+    if (headerSize != HEADER_SIZE)
+        return Fail(MidiErrorCode::InvalidHeaderSize);
+    if (m_Format > 2)
+        return Fail(MidiErrorCode::InvalidFormat);
+    if (m_Division == 0)
+        return Fail(MidiErrorCode::InvalidDivision);
+
+    // The same limits as MidiParser::Open
+    if (m_Format == 2)
+        return Fail(MidiErrorCode::UnsupportedFormat);
+    if (m_Division & 0x8000)
+        return Fail(MidiErrorCode::UnsupportedDivision);
+
+    Consume(reader.GetPosition());
+    m_State = m_TrackCount > 0 ? State::ChunkHeader : State::End;
+    return Status::Event;
+}
+
+MidiStreamParser::Status MidiStreamParser::ReadChunkHeader() {
+    if (m_TrackIndex >= m_TrackCount) {
+        m_State = State::End;
+        return Status::End;
+    }
+
+    if (Buffered() < 8)
+        return m_InputFinished ? Fail(MidiErrorCode::MissingTrackChunk) : Status::NeedMoreData;
+
+    ByteReader reader(BufferData(), Buffered());
+    uint32_t type = reader.ReadInteger();
+    m_ChunkRemaining = reader.ReadInteger();
+    Consume(reader.GetPosition());
+
+    // Chunks of an unknown type must be skipped
+    if (type != MTrk) {
+        m_State = State::SkipChunk;
+        return Status::Event;
+    }
+
+    m_TrackIndex++;
+    m_Tick = 0;
+    m_RunningStatus = MidiEventType::None;
+    m_SysExPending = false;
+    m_State = State::Events;
+    return Status::Event;
+}
+
+// Hands out the end of track so the track's length is not lost (MidiWriter uses it)
+MidiStreamParser::Status MidiStreamParser::EndTrack(StreamEvent& event) {
+    event = { (uint16_t)(m_TrackIndex - 1), m_Tick, EventCategory::Meta, MetaEventType::EndOfTrack, 0, 0, 0, nullptr, 0 };
+    return Status::TrackEnd;
+}
+
+MidiStreamParser::Status MidiStreamParser::ReadStreamEvent(StreamEvent& event) {
+    // A track without an end of track event simply ends with its chunk
+    if (m_ChunkRemaining == 0) {
+        m_State = State::ChunkHeader;
+        return EndTrack(event);
+    }
+
+    size_t available = std::min<size_t>(Buffered(), m_ChunkRemaining);
+    size_t needed = 0;
+    size_t size = MeasureEvent(BufferData(), available, m_RunningStatus, needed);
+
+    if (size == INVALID)
+        return Fail(MidiErrorCode::InvalidVariableLength);
+    if (size == NO_STATUS)
+        return Fail(MidiErrorCode::MissingRunningStatus);
+
+    if (size == INCOMPLETE) {
+        // The event straddles the end of the data fed so far
+        if (available < m_ChunkRemaining && !m_InputFinished) {
+            // Feed would refuse the rest of an event that cannot fit in the buffer
+            if (needed > m_MaxBufferSize || Buffered() >= m_MaxBufferSize)
+                return Fail(MidiErrorCode::EventTooLarge);
+            return Status::NeedMoreData;
+        }
+
+        return Fail(MidiErrorCode::EventOutOfBounds);  // The event runs past the end of its chunk
+    }
+
+    StreamEventSink sink;
+    sink.m_TotalTicks = m_Tick;
+
+    ByteReader reader(BufferData(), size);
+    MidiParser::TrackState state{ m_RunningStatus, m_SysExPending };
+    MidiError error;
+    MidiParser::MidiEventStatus status = MidiParser::ReadEvent<false, false>(sink, reader, state, error);  // MeasureEvent made sure the event is complete
+
+    m_RunningStatus = state.RunningStatus;
+    m_SysExPending = state.SysExPending;
+
+    Consume(size);
+    m_ChunkRemaining -= (uint32_t)size;
+    m_Tick = sink.m_TotalTicks;
+
+    switch (status) {
+        case MidiParser::MidiEventStatus::Success:
+            event = { (uint16_t)(m_TrackIndex - 1), m_Tick, sink.Category, sink.Type, sink.Channel, sink.DataA, sink.DataB, sink.Data, sink.Size };
+            return Status::Event;
+        case MidiParser::MidiEventStatus::End:
+            m_State = m_ChunkRemaining > 0 ? State::SkipChunk : State::ChunkHeader;
+            return EndTrack(event);
+        default:
+            error.Offset += m_BytesConsumed - size;  // The reader started at the event
+            error.Track = m_TrackIndex - 1;
+            m_Error = error;
+            m_State = State::Error;
+            return Status::Error;
+    }
+}
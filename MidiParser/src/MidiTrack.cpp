@@ -1,20 +1,22 @@
 #include "MidiTrack.h"
+#include "Instrumentation.h"
+#include "PayloadArena.h"
 
-#define MIDI_EVENT_SIZE 3  // The approximate size of one MIDI event (in the file)
+#include <algorithm>
 
-MidiTrack::MidiTrack(size_t sizeBytes) : m_Capacity(sizeBytes) {
+MidiTrack::MidiTrack(size_t sizeBytes) {
     ReserveBytes(sizeBytes);
 }
 
 MidiTrack::MidiTrack(const MidiTrack& other)
-    : m_PushIndex(other.m_PushIndex), m_Capacity(other.m_Capacity), m_Indicies(std::move(other.m_Indicies)), m_TotalTicks(other.m_TotalTicks) {
+    : m_PushIndex(other.m_PushIndex), m_Capacity(other.m_Capacity), m_Indicies(other.m_Indicies), m_Payloads(other.m_Payloads), m_Source(other.m_Source), m_TotalTicks(other.m_TotalTicks) {
 
     m_Data = new uint8_t[m_Capacity];
     std::copy(other.m_Data, other.m_Data + other.m_Capacity, m_Data);
 }
 
 MidiTrack::MidiTrack(MidiTrack&& other) noexcept
-    : m_Data(other.m_Data), m_PushIndex(other.m_PushIndex), m_Capacity(other.m_Capacity), m_Indicies(std::move(other.m_Indicies)), m_TotalTicks(other.m_TotalTicks) {
+    : m_Data(other.m_Data), m_PushIndex(other.m_PushIndex), m_Capacity(other.m_Capacity), m_Indicies(std::move(other.m_Indicies)), m_Payloads(std::move(other.m_Payloads)), m_Source(std::move(other.m_Source)), m_TotalTicks(other.m_TotalTicks) {
 
     other.m_Data = nullptr;
     other.m_PushIndex = 0;
@@ -23,7 +25,7 @@ MidiTrack::MidiTrack(MidiTrack&& other) noexcept
 }
 
 MidiTrack::~MidiTrack() {
-    for (int i = 0; i < m_Indicies.size(); i++)
+    for (size_t i = 0; i < m_Indicies.size(); i++)
         ((Event*)&m_Data[m_Indicies[i]])->~Event();  // Calls the destructor for each event
     delete[] m_Data;
 }
@@ -41,6 +43,8 @@ MidiTrack& MidiTrack::operator=(const MidiTrack& other) {
 
         m_PushIndex = other.m_PushIndex;
         m_Indicies = other.m_Indicies;
+        m_Payloads = other.m_Payloads;
+        m_Source = other.m_Source;
         m_TotalTicks = other.m_TotalTicks;
     }
 
@@ -55,6 +59,8 @@ MidiTrack& MidiTrack::operator=(MidiTrack&& other) noexcept {
         m_PushIndex = other.m_PushIndex;
         m_Capacity = other.m_Capacity;
         m_Indicies = std::move(other.m_Indicies);
+        m_Payloads = std::move(other.m_Payloads);
+        m_Source = std::move(other.m_Source);
         m_TotalTicks = other.m_TotalTicks;
 
         other.m_Data = nullptr;
@@ -67,10 +73,15 @@ MidiTrack& MidiTrack::operator=(MidiTrack&& other) noexcept {
 }
 
 void MidiTrack::ReserveBytes(size_t sizeBytes) {
+    if (sizeBytes <= m_Capacity)
+        return;
+
+    MIDI_STATS_ALLOCATION(m_Data != nullptr);
+
     if (m_Data != nullptr) {  // Checks if m_Data has already been initialized
         uint8_t* newData = new uint8_t[sizeBytes];
 
-        std::copy(m_Data, m_Data + m_Capacity, newData);
+        std::copy(m_Data, m_Data + m_PushIndex, newData);
         delete[] m_Data;
 
         m_Capacity = sizeBytes;
@@ -79,10 +90,37 @@ void MidiTrack::ReserveBytes(size_t sizeBytes) {
         m_Capacity = sizeBytes;
         m_Data = new uint8_t[sizeBytes];
     }
-    m_Indicies.reserve(sizeBytes / MIDI_EVENT_SIZE);
 }
 
 void MidiTrack::ReserveEvents(size_t eventCount) {
-    ReserveBytes(eventCount * MIDI_EVENT_SIZE);
+    ReserveBytes(eventCount * std::max({ sizeof(MidiEvent), sizeof(MetaEvent), sizeof(SysExEvent) }));
+
+    MIDI_STATS_RESERVE(m_Indicies, eventCount);
+    m_Indicies.reserve(eventCount);
+}
+
+void MidiTrack::Reserve(size_t midiEvents, size_t metaEvents, size_t sysExEvents) {
+    ReserveBytes(midiEvents * sizeof(MidiEvent) + metaEvents * sizeof(MetaEvent) + sysExEvents * sizeof(SysExEvent));
+
+    size_t eventCount = midiEvents + metaEvents + sysExEvents;
+    MIDI_STATS_RESERVE(m_Indicies, eventCount);
     m_Indicies.reserve(eventCount);
 }
+
+void MidiTrack::Clear() {
+    for (size_t i = 0; i < m_Indicies.size(); i++)
+        ((Event*)&m_Data[m_Indicies[i]])->~Event();
+
+    m_PushIndex = 0;
+    m_Indicies.clear();
+    if (m_Payloads)
+        m_Payloads->Reset();
+    m_TotalTicks = 0;
+}
+
+void MidiTrack::AppendMetaEvent(uint32_t tick, MetaEventType type, const uint8_t* data, uint32_t size) {
+    uint8_t* payload = m_Payloads->Allocate(size);
+    std::copy(data, data + size, payload);
+
+    AppendEvent<MetaEvent>(tick, 0.0f, type, payload, size);
+}
@@ -0,0 +1,347 @@
+#include "MidiWriter.h"
+#include "MidiParser.h"
+
+#include <cstdio>
+#include <memory>
+
+#define HEADER_SIZE 6   // The size of the MIDI header (always 6)
+#define CHUNK_HEADER_SIZE 8  // Chunk type and size
+
+// Output that only counts bytes, used for the sizing pass
+class SizeCounter {
+public:
+    inline void WriteByte(uint8_t) { m_Size++; }
+    inline void WriteBytes(const uint8_t*, size_t size) { m_Size += size; }
+
+    inline size_t GetSize() const { return m_Size; }
+private:
+    size_t m_Size = 0;
+};
+
+// Output into memory that the sizing pass made large enough
+class BufferOutput {
+public:
+    BufferOutput(uint8_t* buffer) : m_Position(buffer) {}
+
+    inline void WriteByte(uint8_t byte) { *m_Position++ = byte; }
+    inline void WriteBytes(const uint8_t* data, size_t size) {
+        std::copy(data, data + size, m_Position);
+        m_Position += size;
+    }
+
+    inline void WriteInteger(uint32_t number) {
+        WriteByte((uint8_t)(number >> 24));
+        WriteByte((uint8_t)(number >> 16));
+        WriteByte((uint8_t)(number >> 8));
+        WriteByte((uint8_t)number);
+    }
+
+    inline void WriteShort(uint16_t number) {
+        WriteByte((uint8_t)(number >> 8));
+        WriteByte((uint8_t)number);
+    }
+
+    inline uint8_t* GetPosition() const { return m_Position; }
+private:
+    uint8_t* m_Position;
+};
+
+template<typename Output>
+static inline void WriteVariableLengthValue(Output& output, uint32_t value) {
+    // Minimal encoding: only as many 7 bit groups as the value needs
+    if (value >= 1 << 21) output.WriteByte((uint8_t)(0x80 | (value >> 21 & 0x7f)));
+    if (value >= 1 << 14) output.WriteByte((uint8_t)(0x80 | (value >> 14 & 0x7f)));
+    if (value >= 1 << 7)  output.WriteByte((uint8_t)(0x80 | (value >> 7 & 0x7f)));
+    output.WriteByte((uint8_t)(value & 0x7f));
+}
+
+// What the writer needs to know about one event, whatever track type it came from
+struct WriterEvent {
+    uint32_t Tick;
+    EventCategory Category;
+    uint8_t Type;  // MidiEventType, MetaEventType, unused for SysEx
+    uint8_t Channel;
+    uint8_t DataA;
+    uint8_t DataB;
+    const uint8_t* Data;
+    uint32_t Size;
+};
+
+template<typename Function>
+static void ForEachEvent(const MidiTrack& track, Function&& function) {
+    for (size_t i = 0; i < track.GetEventCount(); i++) {
+        const Event* event = track[i];
+
+        switch (event->GetCategory()) {
+            case EventCategory::Midi:
+            {
+                const MidiEvent* midiEvent = (const MidiEvent*)event;
+                function(WriterEvent{ event->GetTick(), EventCategory::Midi, midiEvent->GetType(), midiEvent->GetChannel(),
+                    midiEvent->GetDataA(), midiEvent->GetDataB(), nullptr, 0 });
+                break;
+            }
+            case EventCategory::Meta:
+            {
+                const MetaEvent* metaEvent = (const MetaEvent*)event;
+                function(WriterEvent{ event->GetTick(), EventCategory::Meta, metaEvent->GetType(), 0, 0, 0, metaEvent->Data(), (uint32_t)metaEvent->GetSize() });
+                break;
+            }
+            default:
+            {
+                const SysExEvent* sysExEvent = (const SysExEvent*)event;
+                function(WriterEvent{ event->GetTick(), event->GetCategory(), 0, 0, 0, 0, sysExEvent->Data(), (uint32_t)sysExEvent->GetSize() });
+                break;
+            }
+        }
+    }
+}
+
+template<typename Function>
+static void ForEachEvent(const CompactTrack& track, Function&& function) {
+    for (const CompactEvent& event : track) {
+        switch (event.Category) {
+            case EventCategory::Midi:
+                function(WriterEvent{ event.Tick, EventCategory::Midi, event.GetMidiType(), event.GetChannel(), event.GetDataA(), event.GetDataB(), nullptr, 0 });
+                break;
+            case EventCategory::Meta:
+            {
+                CompactMetaEvent metaEvent = track.GetMetaEvent(event);
+                function(WriterEvent{ event.Tick, EventCategory::Meta, metaEvent.Type, 0, 0, 0, metaEvent.Data, metaEvent.Size });
+                break;
+            }
+            default:
+            {
+                CompactSysExEvent sysExEvent = track.GetSysExEvent(event);
+                function(WriterEvent{ event.Tick, event.Category, 0, 0, 0, 0, sysExEvent.Data, sysExEvent.Size });
+                break;
+            }
+        }
+    }
+}
+
+static inline bool IsEndOfTrack(const StreamEvent& event) {
+    return event.Category == EventCategory::Meta && event.Type == MetaEventType::EndOfTrack;
+}
+
+// The events of one track in a StreamEvent list, which may hold several tracks.
+// The track lasts until its last event, including an EndOfTrack event.
+struct StreamTrack {
+    const std::vector<StreamEvent>& Events;
+    uint16_t Index;
+
+    uint32_t TotalTicks() const {
+        for (auto it = Events.rbegin(); it != Events.rend(); it++)
+            if (it->Track == Index)
+                return it->Tick;
+        return 0;
+    }
+};
+
+template<typename Function>
+static void ForEachEvent(const StreamTrack& track, Function&& function) {
+    for (const StreamEvent& event : track.Events)
+        if (event.Track == track.Index && !IsEndOfTrack(event))  // WriteTrack adds its own
+            function(WriterEvent{ event.Tick, event.Category, event.Type, event.Channel, event.DataA, event.DataB, event.Data, event.Size });
+}
+
+// Adapts each kind of input to a header plus a list of tracks
+struct ParserSource {
+    const MidiParser& Parser;
+
+    uint16_t GetFormat() const { return Parser.GetFormat(); }
+    uint16_t GetDivision() const { return Parser.GetDivision(); }
+
+    template<typename Function>
+    void ForEachTrack(Function&& function) const {
+        if (Parser.GetOptions().Storage == TrackStorage::Compact) {
+            for (const CompactTrack& track : Parser.GetCompactTracks())
+                function(track);
+        } else {
+            for (const MidiTrack& track : Parser.GetTracks())
+                function(track);
+        }
+    }
+
+    uint16_t GetTrackCount() const {
+        return (uint16_t)(Parser.GetOptions().Storage == TrackStorage::Compact ? Parser.GetCompactTracks().size() : Parser.GetTracks().size());
+    }
+};
+
+struct StreamSource {
+    const std::vector<StreamEvent>& Events;
+    uint16_t Format;
+    uint16_t Division;
+
+    uint16_t GetFormat() const { return Format; }
+    uint16_t GetDivision() const { return Division; }
+
+    uint16_t GetTrackCount() const {
+        uint16_t count = 0;
+        for (const StreamEvent& event : Events)
+            if (event.Track >= count)
+                count = event.Track + 1;
+        return count;
+    }
+
+    template<typename Function>
+    void ForEachTrack(Function&& function) const {
+        uint16_t trackCount = GetTrackCount();
+        for (uint16_t i = 0; i < trackCount; i++)
+            function(StreamTrack{ Events, i });
+    }
+};
+
+template<typename Output, typename Track>
+void MidiWriter::WriteTrack(Output& output, const Track& track) const {
+    uint32_t previousTick = 0;
+    uint8_t runningStatus = 0;
+
+    ForEachEvent(track, [&](const WriterEvent& event) {
+        // Events before the previous one would need a negative delta time
+        uint32_t deltaTime = event.Tick > previousTick ? event.Tick - previousTick : 0;
+        previousTick += deltaTime;
+        WriteVariableLengthValue(output, deltaTime);
+
+        if (event.Category == EventCategory::Midi) {
+            uint8_t type = event.Type;
+            uint8_t dataB = event.DataB;
+
+            // A note off with velocity 0 reads back the same as a note on with velocity 0
+            if (m_RunningStatus && type == MidiEventType::NoteOff && dataB == 0 && runningStatus == (MidiEventType::NoteOn | event.Channel))
+                type = MidiEventType::NoteOn;
+
+            uint8_t status = type | event.Channel;
+            if (!m_RunningStatus || status != runningStatus)
+                output.WriteByte(status);
+            runningStatus = status;
+
+            output.WriteByte(event.DataA);
+            if (type != MidiEventType::ProgramChange && type != MidiEventType::ChannelAfterTouch)
+                output.WriteByte(dataB);
+        } else {
+            // Meta and SysEx events cancel running status
+            runningStatus = 0;
+
+            if (event.Category == EventCategory::Meta) {
+                output.WriteByte(0xff);
+                output.WriteByte(event.Type);
+            } else {
+                output.WriteByte((uint8_t)event.Category);
+            }
+
+            WriteVariableLengthValue(output, event.Size);
+            output.WriteBytes(event.Data, event.Size);
+        }
+    });
+
+    // The parser does not keep end of track events, so one is always added
+    uint32_t totalTicks = track.TotalTicks();
+    WriteVariableLengthValue(output, totalTicks > previousTick ? totalTicks - previousTick : 0);
+    output.WriteByte(0xff);
+    output.WriteByte(MetaEventType::EndOfTrack);
+    output.WriteByte(0);
+}
+
+template<typename Source>
+size_t MidiWriter::Measure(const Source& source) const {
+    size_t size = CHUNK_HEADER_SIZE + HEADER_SIZE;
+
+    source.ForEachTrack([&](const auto& track) {
+        SizeCounter counter;
+        WriteTrack(counter, track);
+        size += CHUNK_HEADER_SIZE + counter.GetSize();
+    });
+
+    return size;
+}
+
+template<typename Source>
+void MidiWriter::Encode(const Source& source, uint8_t* buffer) const {
+    BufferOutput output(buffer);
+    output.WriteBytes((const uint8_t*)"MThd", 4);
+    output.WriteInteger(HEADER_SIZE);
+    output.WriteShort(source.GetFormat());
+    output.WriteShort(source.GetTrackCount());
+    output.WriteShort(source.GetDivision());
+
+    source.ForEachTrack([&](const auto& track) {
+        output.WriteBytes((const uint8_t*)"MTrk", 4);
+
+        // The chunk size is filled in once the track is written, so no sizes have to be kept from Measure
+        uint8_t* chunkSize = output.GetPosition();
+        output.WriteInteger(0);
+        WriteTrack(output, track);
+
+        BufferOutput(chunkSize).WriteInteger((uint32_t)(output.GetPosition() - chunkSize - 4));
+    });
+}
+
+template<typename Source>
+size_t MidiWriter::ComputeSize(const Source& source) const {
+    return Measure(source);
+}
+
+template<typename Source>
+size_t MidiWriter::Write(const Source& source, uint8_t* buffer, size_t capacity) const {
+    size_t size = Measure(source);
+    if (size > capacity)
+        return 0;
+
+    Encode(source, buffer);
+    return size;
+}
+
+template<typename Source>
+bool MidiWriter::Write(const Source& source, std::vector<uint8_t>& output) const {
+    output.resize(Measure(source));
+
+    Encode(source, output.data());
+    return true;
+}
+
+template<typename Source>
+bool MidiWriter::WriteFile(const Source& source, const std::string& file) const {
+    size_t size = Measure(source);
+
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+    Encode(source, buffer.get());
+
+    std::FILE* output = std::fopen(file.c_str(), "wb");
+    if (output == nullptr)
+        return false;
+
+    bool success = std::fwrite(buffer.get(), 1, size, output) == size;
+    return std::fclose(output) == 0 && success;
+}
+
+size_t MidiWriter::ComputeSize(const MidiParser& parser) const {
+    return ComputeSize(ParserSource{ parser });
+}
+
+size_t MidiWriter::Write(const MidiParser& parser, uint8_t* buffer, size_t capacity) const {
+    return Write(ParserSource{ parser }, buffer, capacity);
+}
+
+bool MidiWriter::Write(const MidiParser& parser, std::vector<uint8_t>& output) const {
+    return Write(ParserSource{ parser }, output);
+}
+
+bool MidiWriter::WriteFile(const MidiParser& parser, const std::string& file) const {
+    return WriteFile(ParserSource{ parser }, file);
+}
+
+size_t MidiWriter::ComputeSize(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division) const {
+    return ComputeSize(StreamSource{ events, format, division });
+}
+
+size_t MidiWriter::Write(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division, uint8_t* buffer, size_t capacity) const {
+    return Write(StreamSource{ events, format, division }, buffer, capacity);
+}
+
+bool MidiWriter::Write(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division, std::vector<uint8_t>& output) const {
+    return Write(StreamSource{ events, format, division }, output);
+}
+
+bool MidiWriter::WriteFile(const std::vector<StreamEvent>& events, uint16_t format, uint16_t division, const std::string& file) const {
+    return WriteFile(StreamSource{ events, format, division }, file);
+}
@@ -0,0 +1,132 @@
+#include "NoteIndex.h"
+#include "MidiParser.h"
+
+#include <algorithm>
+#include <numeric>
+
+void NoteIndex::Build(const MidiParser& parser) {
+    ColumnarExporter exporter(true);
+    exporter.Export(parser);
+
+    const ColumnarNotes& notes = exporter.GetNotes();
+    size_t noteCount = notes.GetSize();
+
+    // Notes are exported in NoteOn order, which is already by start
+    std::vector<uint32_t> order(noteCount);
+    std::iota(order.begin(), order.end(), 0);
+    if (!std::is_sorted(notes.Start.begin(), notes.Start.end()))
+        std::stable_sort(order.begin(), order.end(), [&notes](uint32_t a, uint32_t b) { return notes.Start[a] < notes.Start[b]; });
+
+    m_Notes.Clear();
+    m_Notes.Reserve(noteCount);
+    for (uint32_t note : order) {
+        m_Notes.Start.push_back(notes.Start[note]);
+        m_Notes.Duration.push_back(notes.Duration[note]);
+        m_Notes.Track.push_back(notes.Track[note]);
+        m_Notes.Channel.push_back(notes.Channel[note]);
+        m_Notes.Pitch.push_back(notes.Pitch[note]);
+        m_Notes.Velocity.push_back(notes.Velocity[note]);
+    }
+
+    m_TempoMap = parser.GetTempoMap();
+
+    m_Nodes.clear();
+    m_ByStart.clear();
+    m_ByEnd.clear();
+    m_ByStart.reserve(noteCount);
+    m_ByEnd.reserve(noteCount);
+
+    std::iota(order.begin(), order.end(), 0);
+    m_Root = BuildNode(order);
+}
+
+inline uint32_t NoteIndex::EndOf(uint32_t note) const {
+    return m_Notes.Start[note] + std::max<uint32_t>(m_Notes.Duration[note], 1);
+}
+
+int32_t NoteIndex::BuildNode(std::vector<uint32_t>& notes) {
+    if (notes.empty())
+        return -1;
+
+    // The median start keeps the tree O(log n) deep: at most half of the notes start after it
+    uint32_t center = m_Notes.Start[notes[notes.size() / 2]];
+
+    std::vector<uint32_t> left, right;
+    size_t first = m_ByStart.size();
+
+    for (uint32_t note : notes) {
+        if (EndOf(note) <= center)
+            left.push_back(note);
+        else if (m_Notes.Start[note] > center)
+            right.push_back(note);
+        else
+            m_ByStart.push_back(note);  // Still sorted by start
+    }
+
+    m_ByEnd.insert(m_ByEnd.end(), m_ByStart.begin() + first, m_ByStart.end());
+    std::sort(m_ByEnd.begin() + first, m_ByEnd.end(), [this](uint32_t a, uint32_t b) { return EndOf(a) > EndOf(b); });
+
+    notes.clear();
+    notes.shrink_to_fit();
+
+    int32_t index = (int32_t)m_Nodes.size();
+    m_Nodes.push_back({ center, (uint32_t)first, (uint32_t)(m_ByStart.size() - first) });
+
+    int32_t leftNode = BuildNode(left);
+    int32_t rightNode = BuildNode(right);
+    m_Nodes[index].Left = leftNode;
+    m_Nodes[index].Right = rightNode;
+
+    return index;
+}
+
+void NoteIndex::NotesAt(uint32_t tick, std::vector<uint32_t>& notes) const {
+    int32_t index = m_Root;
+
+    while (index >= 0) {
+        const Node& node = m_Nodes[index];
+        const uint32_t* first = m_ByStart.data() + node.First;
+
+        // Every note of the node contains the centre, so only the side of tick has to be checked
+        if (tick < node.Center) {
+            for (const uint32_t* note = first; note != first + node.Count && m_Notes.Start[*note] <= tick; note++)
+                notes.push_back(*note);
+            index = node.Left;
+        } else {
+            first = m_ByEnd.data() + node.First;
+            for (const uint32_t* note = first; note != first + node.Count && EndOf(*note) > tick; note++)
+                notes.push_back(*note);
+            index = node.Right;
+        }
+    }
+}
+
+void NoteIndex::NotesIn(uint32_t beginTick, uint32_t endTick, std::vector<uint32_t>& notes) const {
+    if (endTick <= beginTick)
+        return;
+
+    // Notes that started by beginTick and still sound, then the ones starting inside the range
+    NotesAt(beginTick, notes);
+
+    auto first = std::upper_bound(m_Notes.Start.begin(), m_Notes.Start.end(), beginTick);
+    auto last = std::lower_bound(first, m_Notes.Start.end(), endTick);
+    for (auto note = first; note != last; note++)
+        notes.push_back((uint32_t)(note - m_Notes.Start.begin()));
+}
+
+void NoteIndex::NotesAtTime(uint64_t microseconds, std::vector<uint32_t>& notes) const {
+    uint64_t tick = m_TempoMap.MicrosecondsToTicks(microseconds);
+    if (tick <= UINT32_MAX)
+        NotesAt((uint32_t)tick, notes);
+}
+
+void NoteIndex::NotesInTime(uint64_t beginMicroseconds, uint64_t endMicroseconds, std::vector<uint32_t>& notes) const {
+    if (endMicroseconds <= beginMicroseconds)
+        return;
+
+    // A note sounds at a time if it sounds at the last tick not after it
+    uint64_t beginTick = m_TempoMap.MicrosecondsToTicks(beginMicroseconds);
+    uint64_t endTick = m_TempoMap.MicrosecondsToTicks(endMicroseconds - 1) + 1;
+
+    NotesIn((uint32_t)std::min<uint64_t>(beginTick, UINT32_MAX), (uint32_t)std::min<uint64_t>(endTick, UINT32_MAX), notes);
+}
@@ -0,0 +1,39 @@
+#include "PayloadArena.h"
+#include "Instrumentation.h"
+
+#define MIN_BLOCK_SIZE 4096
+
+void PayloadArena::Reserve(size_t sizeBytes) {
+    // Looks for a block (the current one or a recycled one) with enough room
+    while (m_BlockIndex < m_Blocks.size()) {
+        if (m_Blocks[m_BlockIndex].Size - m_BlockPosition >= sizeBytes)
+            return;
+
+        m_BlockIndex++;
+        m_BlockPosition = 0;
+    }
+
+    AddBlock(sizeBytes);
+}
+
+uint8_t* PayloadArena::Allocate(size_t sizeBytes) {
+    if (m_BlockIndex >= m_Blocks.size() || m_Blocks[m_BlockIndex].Size - m_BlockPosition < sizeBytes)
+        Reserve(sizeBytes > MIN_BLOCK_SIZE ? sizeBytes : MIN_BLOCK_SIZE);
+
+    uint8_t* memory = m_Blocks[m_BlockIndex].Data.get() + m_BlockPosition;
+    m_BlockPosition += sizeBytes;
+    return memory;
+}
+
+void PayloadArena::Reset() {
+    m_BlockIndex = 0;
+    m_BlockPosition = 0;
+}
+
+void PayloadArena::AddBlock(size_t sizeBytes) {
+    MIDI_STATS_ALLOCATION(false);
+    m_Blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[sizeBytes]), sizeBytes });
+    m_BlockIndex = m_Blocks.size() - 1;
+    m_BlockPosition = 0;
+    m_Capacity += sizeBytes;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for meta event payloads. Memory is only released when the
+// arena is destroyed; Reset() keeps the blocks so a reparse does not allocate.
+class PayloadArena {
+public:
+    PayloadArena() = default;
+    PayloadArena(const PayloadArena& other) = delete;
+
+    PayloadArena& operator=(const PayloadArena& other) = delete;
+
+    // Makes sure the next sizeBytes can be allocated without another block
+    void Reserve(size_t sizeBytes);
+
+    uint8_t* Allocate(size_t sizeBytes);
+    void Reset();
+
+    inline size_t GetCapacity() const { return m_Capacity; }
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> Data;
+        size_t Size;
+    };
+
+    void AddBlock(size_t sizeBytes);
+private:
+    std::vector<Block> m_Blocks;
+    size_t m_BlockIndex = 0;  // Block currently being filled
+    size_t m_BlockPosition = 0;  // Bytes used in that block
+    size_t m_Capacity = 0;  // Total bytes across all blocks
+};
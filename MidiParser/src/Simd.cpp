@@ -0,0 +1,106 @@
+#include "Simd.h"
+
+#if defined(__AVX2__)
+    #define MIDI_SIMD_AVX2
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MIDI_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+static inline bool MatchesTag(const uint8_t* data, uint32_t tag) {
+    uint32_t word;
+    std::memcpy(&word, data, sizeof(uint32_t));
+    if constexpr (Endian::Little)
+        word = Endian::FlipEndian(word);
+    return word == tag;
+}
+
+const char* Simd::GetInstructionSet() {
+#if defined(MIDI_SIMD_AVX2)
+    return "AVX2";
+#elif defined(MIDI_SIMD_SSE2)
+    return "SSE2";
+#else
+    return "Scalar";
+#endif
+}
+
+size_t Simd::FindTag(const uint8_t* data, size_t size, uint32_t tag) {
+    if (size < 4)
+        return size;
+
+    size_t last = size - 4;  // Last offset a tag can start at
+    size_t i = 0;
+
+    // Candidates are positions where both the first and the last byte of the tag
+    // match. Four vectors are tested per step so blocks without one cost one branch.
+#if defined(MIDI_SIMD_AVX2)
+    const __m256i first = _mm256_set1_epi8((char)(tag >> 24));
+    const __m256i fourth = _mm256_set1_epi8((char)tag);
+
+    auto candidates = [&](size_t offset) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(data + offset));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(data + offset + 3));
+        return _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(d, fourth));
+    };
+
+    for (; i + 128 <= last + 1; i += 128) {
+        __m256i c0 = candidates(i), c1 = candidates(i + 32), c2 = candidates(i + 64), c3 = candidates(i + 96);
+        if (_mm256_testz_si256(_mm256_or_si256(_mm256_or_si256(c0, c1), _mm256_or_si256(c2, c3)), _mm256_set1_epi8(-1)))
+            continue;
+
+        const __m256i blocks[] = { c0, c1, c2, c3 };
+        for (size_t block = 0; block < 4; block++) {
+            for (uint32_t mask = (uint32_t)_mm256_movemask_epi8(blocks[block]); mask != 0; mask &= mask - 1) {
+                size_t offset = i + block * 32 + CountTrailingZeros(mask);
+                if (MatchesTag(data + offset, tag))
+                    return offset;
+            }
+        }
+    }
+#elif defined(MIDI_SIMD_SSE2)
+    const __m128i first = _mm_set1_epi8((char)(tag >> 24));
+    const __m128i fourth = _mm_set1_epi8((char)tag);
+
+    auto candidates = [&](size_t offset) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(data + offset));
+        __m128i d = _mm_loadu_si128((const __m128i*)(data + offset + 3));
+        return _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(d, fourth));
+    };
+
+    for (; i + 64 <= last + 1; i += 64) {
+        __m128i c0 = candidates(i), c1 = candidates(i + 16), c2 = candidates(i + 32), c3 = candidates(i + 48);
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3))) == 0)
+            continue;
+
+        const __m128i blocks[] = { c0, c1, c2, c3 };
+        for (size_t block = 0; block < 4; block++) {
+            for (uint32_t mask = (uint32_t)_mm_movemask_epi8(blocks[block]); mask != 0; mask &= mask - 1) {
+                size_t offset = i + block * 16 + CountTrailingZeros(mask);
+                if (MatchesTag(data + offset, tag))
+                    return offset;
+            }
+        }
+    }
+#endif
+
+    size_t offset = FindTagScalar(data + i, size - i, tag);
+    return offset == size - i ? size : i + offset;
+}
+
+size_t Simd::FindTagScalar(const uint8_t* data, size_t size, uint32_t tag) {
+    if (size < 4)
+        return size;
+
+    const uint8_t* end = data + size - 3;
+    for (const uint8_t* p = data; p < end; p++) {
+        p = (const uint8_t*)std::memchr(p, (int)(tag >> 24), end - p);
+        if (p == nullptr)
+            break;
+        if (MatchesTag(p, tag))
+            return p - data;
+    }
+
+    return size;
+}
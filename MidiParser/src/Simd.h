@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Endian.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__BMI2__)
+    #include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+// Vectorised byte kernels. FindTag uses AVX2 or SSE2 when the compiler targets
+// them (see MIDI_PARSER_AVX2 in CMake) and plain C++ otherwise.
+class Simd {
+public:
+    Simd() = delete;
+
+    static const char* GetInstructionSet();  // "AVX2", "SSE2" or "Scalar"
+
+    // Offset of the first occurrence of tag (big endian, e.g. "MTrk"), size if there is none
+    static size_t FindTag(const uint8_t* data, size_t size, uint32_t tag);
+    static size_t FindTagScalar(const uint8_t* data, size_t size, uint32_t tag);
+
+    // Decodes a variable length value from one 4 byte load, so 4 bytes must be
+    // readable at data. Returns -1 if the value is longer than 4 bytes.
+    static inline int32_t ReadVariableLength(const uint8_t* data, uint32_t& length) {
+        if constexpr (!Endian::Little)
+            return ReadVariableLengthScalar(data, length);
+
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(uint32_t));
+
+        uint32_t ends = ~word & 0x80808080;  // High bit clear marks the last byte
+        if (ends == 0)
+            return -1;
+
+        length = (CountTrailingZeros(ends) >> 3) + 1;
+
+        // Moves the first byte to the top, then packs the 7 bit groups together
+        uint32_t bytes = Endian::FlipEndian(word) >> (32 - length * 8);
+#if defined(__BMI2__)
+        return (int32_t)_pext_u32(bytes, 0x7f7f7f7f);
+#else
+        return (int32_t)((bytes & 0x7f) | (bytes & 0x7f00) >> 1 | (bytes & 0x7f0000) >> 2 | (bytes & 0x7f000000) >> 3);
+#endif
+    }
+
+    static inline int32_t ReadVariableLengthScalar(const uint8_t* data, uint32_t& length) {
+        int32_t value = 0;
+        for (uint32_t i = 0; i < 4; i++) {
+            value = value << 7 | (data[i] & 0x7f);
+            if (!(data[i] & 0x80)) {
+                length = i + 1;
+                return value;
+            }
+        }
+
+        return -1;
+    }
+
+    static inline uint32_t CountTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return index;
+#else
+        return __builtin_ctz(value);
+#endif
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "MidiEvent.h"
+
+#include <array>
+#include <cstdint>
+
+// How ReadEvent decodes an event with a given status byte
+enum class StatusKind : uint8_t {
+    Invalid,  // No running status (0x00), data bytes, and 0xf1 to 0xfe
+    Channel,
+    SysEx,  // 0xf0 and 0xf7
+    Meta  // 0xff
+};
+
+struct StatusInfo {
+    StatusKind Kind;
+    EventCategory Category;
+    uint8_t DataBytes;  // Channel events: 1 for program change and channel aftertouch, otherwise 2
+};
+
+constexpr std::array<StatusInfo, 256> MakeStatusTable() {
+    std::array<StatusInfo, 256> table{};
+
+    for (unsigned status = 0; status < 256; status++) {
+        StatusInfo& info = table[status];
+        info = { StatusKind::Invalid, EventCategory::Midi, 0 };
+
+        if (status >= 0x80 && status < 0xf0) {
+            unsigned type = status & 0xf0;
+            info.Kind = StatusKind::Channel;
+            info.DataBytes = type == MidiEventType::ProgramChange || type == MidiEventType::ChannelAfterTouch ? 1 : 2;
+        } else if (status == 0xf0 || status == 0xf7) {
+            info.Kind = StatusKind::SysEx;
+            info.Category = (EventCategory)status;
+        } else if (status == 0xff) {
+            info.Kind = StatusKind::Meta;
+            info.Category = EventCategory::Meta;
+        }
+    }
+
+    return table;
+}
+
+// Indexed by the status byte, or the running status for a data byte
+inline constexpr std::array<StatusInfo, 256> StatusTable = MakeStatusTable();
+
+static_assert(StatusTable[0x00].Kind == StatusKind::Invalid, "A missing running status must not decode");
+static_assert(StatusTable[0xc5].DataBytes == 1 && StatusTable[0xe5].DataBytes == 2, "Wrong data lengths");
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "MidiEvent.h"
+
+#include <cstdint>
+
+// Stands in for a track when MidiParser::ReadEvent decodes a single streamed event
+struct StreamEventSink {
+    uint32_t m_TotalTicks = 0;  // The event's tick; ReadEvent passes it to the Append calls as well
+
+    EventCategory Category = EventCategory::Midi;
+    uint8_t Type = 0;
+    uint8_t Channel = 0;
+    uint8_t DataA = 0;
+    uint8_t DataB = 0;
+    const uint8_t* Data = nullptr;
+    uint32_t Size = 0;
+
+    inline void AppendMidiEvent(uint32_t, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+        Category = EventCategory::Midi;
+        Type = type;
+        Channel = channel;
+        DataA = dataA;
+        DataB = dataB;
+        Data = nullptr;
+        Size = 0;
+    }
+
+    inline void AppendMetaEvent(uint32_t, MetaEventType type, const uint8_t* data, uint32_t size) {
+        Category = EventCategory::Meta;
+        Type = type;
+        Channel = 0;
+        DataA = 0;
+        DataB = 0;
+        Data = data;
+        Size = size;
+    }
+
+    inline void AppendSysExEvent(uint32_t, EventCategory category, SysExPacket packet, const uint8_t* data, uint32_t size) {
+        Category = category;
+        Type = (uint8_t)packet;
+        Channel = 0;
+        DataA = 0;
+        DataB = 0;
+        Data = data;
+        Size = size;
+    }
+};
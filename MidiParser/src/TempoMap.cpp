@@ -0,0 +1,71 @@
+#include "TempoMap.h"
+
+#include <algorithm>
+
+#define DEFAULT_TEMPO 500000 // Five hundred thousand microseconds per quarter note or 120 bpm
+
+void TempoMap::Clear() {
+    m_Division = 0;
+    m_Changes.clear();
+}
+
+void TempoMap::Build(uint16_t division, std::vector<TempoChange>&& changes) {
+    m_Division = division;
+    m_Changes = std::move(changes);
+
+    auto byTick = [](const TempoChange& a, const TempoChange& b) {
+        return a.Tick < b.Tick;
+    };
+
+    // They usually are sorted already, and stable_sort allocates
+    if (!std::is_sorted(m_Changes.begin(), m_Changes.end(), byTick))
+        std::stable_sort(m_Changes.begin(), m_Changes.end(), byTick);
+
+    // Keeps only the last change at each tick
+    auto last = std::unique(m_Changes.rbegin(), m_Changes.rend(), [](const TempoChange& a, const TempoChange& b) {
+        return a.Tick == b.Tick;
+    });
+    m_Changes.erase(m_Changes.begin(), last.base());
+
+    if (m_Changes.empty() || m_Changes.front().Tick != 0)
+        m_Changes.insert(m_Changes.begin(), { 0, DEFAULT_TEMPO, 0 });
+
+    m_Changes[0].Microseconds = 0;
+    for (size_t i = 1; i < m_Changes.size(); i++)
+        m_Changes[i].Microseconds = TicksToMicroseconds(m_Changes[i].Tick, i - 1);
+}
+
+uint64_t TempoMap::TicksToMicroseconds(uint64_t tick) const {
+    if (m_Changes.empty() || m_Division == 0)
+        return 0;
+
+    return TicksToMicroseconds(tick, FindChange(tick));
+}
+
+uint64_t TempoMap::MicrosecondsToTicks(uint64_t microseconds) const {
+    if (m_Changes.empty())
+        return 0;
+
+    auto it = std::upper_bound(m_Changes.begin(), m_Changes.end(), microseconds, [](uint64_t microseconds, const TempoChange& change) {
+        return microseconds < change.Microseconds;
+    });
+    const TempoChange& change = *(it - 1);  // The first change is always at time 0
+
+    // The last tick whose time is not after microseconds, so it round trips with TicksToMicroseconds
+    return change.Tick + ((microseconds - change.Microseconds + 1) * m_Division - 1) / change.Tempo;
+}
+
+uint32_t TempoMap::GetTempo(uint64_t tick) const {
+    if (m_Changes.empty())
+        return DEFAULT_TEMPO;
+
+    return m_Changes[FindChange(tick)].Tempo;
+}
+
+size_t TempoMap::FindChange(uint64_t tick) const {
+    auto it = std::upper_bound(m_Changes.begin(), m_Changes.end(), tick, [](uint64_t tick, const TempoChange& change) {
+        return tick < change.Tick;
+    });
+
+    return it == m_Changes.begin() ? 0 : (size_t)(it - m_Changes.begin()) - 1;
+}
@@ -0,0 +1,165 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // The thread calling ParallelFor is one of the workers
+    for (unsigned i = 1; i < threadCount; i++)
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Condition.notify_all();
+
+    for (std::thread& thread : m_Threads)
+        thread.join();
+}
+
+namespace {
+
+    // Indices a worker still has to run. The owner takes from the front, thieves from the back.
+    struct WorkRange {
+        std::mutex Mutex;
+        size_t Begin = 0;
+        size_t End = 0;
+    };
+
+    struct Job {
+        Job(size_t count, unsigned workerCount, const std::function<void(size_t, unsigned)>& function)
+            : Ranges(workerCount), Function(function), Remaining(count) {
+
+            // Contiguous blocks keep neighbouring indices (similar sized work) on one thread
+            for (unsigned i = 0; i < workerCount; i++) {
+                Ranges[i].Begin = count * i / workerCount;
+                Ranges[i].End = count * (i + 1) / workerCount;
+            }
+        }
+
+        bool Take(unsigned worker, size_t& index) {
+            WorkRange& range = Ranges[worker];
+            std::lock_guard<std::mutex> lock(range.Mutex);
+            if (range.Begin == range.End)
+                return false;
+
+            index = range.Begin++;
+            return true;
+        }
+
+        bool Steal(unsigned worker) {
+            for (size_t i = 1; i < Ranges.size(); i++) {
+                WorkRange& victim = Ranges[(worker + i) % Ranges.size()];
+
+                size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> lock(victim.Mutex);
+                    size_t available = victim.End - victim.Begin;
+                    if (available == 0)
+                        continue;
+
+                    size_t stolen = (available + 1) / 2;
+                    end = victim.End;
+                    begin = victim.End - stolen;
+                    victim.End = begin;
+                }
+
+                WorkRange& range = Ranges[worker];
+                std::lock_guard<std::mutex> lock(range.Mutex);
+                range.Begin = begin;
+                range.End = end;
+                return true;
+            }
+
+            return false;
+        }
+
+        void Run(unsigned worker) {
+            for (;;) {
+                size_t index;
+                while (Take(worker, index)) {
+                    Function(index, worker);
+                    Remaining--;
+                }
+
+                if (Remaining == 0 || !Steal(worker))
+                    return;
+            }
+        }
+
+        std::vector<WorkRange> Ranges;
+        const std::function<void(size_t, unsigned)>& Function;
+        std::atomic<size_t> Remaining;
+
+        // Helpers that have not started by the time the caller is done are not waited for;
+        // their ranges were stolen by the threads that did run
+        std::mutex Mutex;
+        std::condition_variable Done;
+        unsigned RunningHelpers = 0;
+        bool Closed = false;
+    };
+
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, unsigned)>& function) {
+    unsigned workerCount = (unsigned)std::min<size_t>(GetThreadCount(), std::max<size_t>(count, 1));
+    auto job = std::make_shared<Job>(count, workerCount, function);
+
+    if (workerCount > 1) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (unsigned worker = 1; worker < workerCount; worker++) {
+                m_Tasks.emplace_back([job, worker]() {
+                    {
+                        std::lock_guard<std::mutex> lock(job->Mutex);
+                        if (job->Closed)
+                            return;
+                        job->RunningHelpers++;
+                    }
+
+                    job->Run(worker);
+
+                    std::lock_guard<std::mutex> lock(job->Mutex);
+                    if (--job->RunningHelpers == 0)
+                        job->Done.notify_one();
+                });
+            }
+        }
+        m_Condition.notify_all();
+    }
+
+    job->Run(0);
+
+    // Helpers may still be running their last index, and function lives on the caller's stack
+    std::unique_lock<std::mutex> lock(job->Mutex);
+    job->Closed = true;
+    job->Done.wait(lock, [&job]() { return job->RunningHelpers == 0; });
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& function) {
+    ParallelFor(count, [&function](size_t index, unsigned) { function(index); });
+}
+
+void ThreadPool::WorkerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_Stop || !m_Tasks.empty(); });
+
+            if (m_Stop && m_Tasks.empty())
+                return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
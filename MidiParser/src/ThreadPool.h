@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads. Work is split into one range of indices per
+// participating thread; a thread that runs out steals half of another's range.
+class ThreadPool {
+public:
+    ThreadPool(unsigned threadCount);  // 0 uses one thread per hardware core
+    ThreadPool(const ThreadPool& other) = delete;
+
+    ~ThreadPool();
+
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    inline unsigned GetThreadCount() const { return (unsigned)m_Threads.size() + 1; }  // Includes the calling thread
+
+    // Calls function(i, worker) for every i in [0, count) and returns once all
+    // calls have finished. worker is in [0, GetThreadCount()) and no two calls
+    // run with the same worker at the same time. The calling thread is worker 0.
+    void ParallelFor(size_t count, const std::function<void(size_t, unsigned)>& function);
+    void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+private:
+    void WorkerLoop();
+private:
+    std::vector<std::thread> m_Threads;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<std::function<void()>> m_Tasks;
+    bool m_Stop = false;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "MidiEvent.h"
+#include "TempoMap.h"
+
+#include <cstdint>
+#include <vector>
+
+// Adds the tempo set by a Tempo meta event; malformed ones are ignored
+inline void AddTempoChange(std::vector<TempoChange>& changes, uint32_t tick, const uint8_t* data, size_t size) {
+    if (size < 3)
+        return;
+
+    uint32_t tempo = data[0] << 16 | data[1] << 8 | data[2];
+    if (tempo != 0)
+        changes.push_back({ tick, tempo, 0 });
+}
+
+// Stands in for a track when MidiParser only needs a track's length and tempo changes
+struct TimingSink {
+    uint32_t m_TotalTicks = 0;
+
+    std::vector<TempoChange>& Changes;
+
+    TimingSink(std::vector<TempoChange>& changes) : Changes(changes) {}
+
+    inline void AppendMidiEvent(uint32_t, MidiEventType, uint8_t, uint8_t, uint8_t) {}
+
+    inline void AppendMetaEvent(uint32_t tick, MetaEventType type, const uint8_t* data, uint32_t size) {
+        if (type == MetaEventType::Tempo)
+            AddTempoChange(Changes, tick, data, size);
+    }
+
+    inline void AppendSysExEvent(uint32_t, EventCategory, SysExPacket, const uint8_t*, uint32_t) {}
+};
@@ -0,0 +1,90 @@
+#include "Test.h"
+
+#include <MidiCache.h>
+#include <MidiParser.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+// Layout of a cache file (see MidiCache.cpp): a 64 byte header, the tempo
+// changes (16 bytes each) and a 64 byte record per track
+#define HEADER_SIZE 64
+#define TEMPO_CHANGE_SIZE 16
+#define TRACK_SIZE 64
+
+// One track with a tempo change at tick 0 and another at tick 96
+static const uint8_t s_File[] = {
+    'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, 0, 96,
+    'M', 'T', 'r', 'k', 0, 0, 0, 34,
+    0x00, 0xff, 0x51, 0x03, 0x07, 0xa1, 0x20,
+    0x00, 0x90, 0x3c, 0x40,
+    0x60, 0xff, 0x51, 0x03, 0x05, 0x00, 0x00,
+    0x00, 0xff, 0x01, 0x04, 't', 'e', 'x', 't',
+    0x60, 0x80, 0x3c, 0x00,
+    0x00, 0xff, 0x2f, 0x00
+};
+
+static bool WriteBytes(const std::string& file, const std::vector<uint8_t>& bytes) {
+    std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+    stream.write((const char*)bytes.data(), bytes.size());
+    return (bool)stream;
+}
+
+template<typename T>
+static void Patch(std::vector<uint8_t>& bytes, size_t offset, T value) {
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+// A damaged cache is rejected by Load, and Open parses the file again instead
+bool CacheRejectsCorruption() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string file = (directory / "MidiParserTests.mid").string();
+    std::string cacheFile = (directory / "MidiParserTests.mpc").string();
+    CHECK(WriteBytes(file, std::vector<uint8_t>(s_File, s_File + sizeof(s_File))));
+
+    for (TrackStorage storage : { TrackStorage::Events, TrackStorage::Compact }) {
+        ParseOptions options;
+        options.Storage = storage;
+
+        MidiParser parser(options);
+        CHECK(parser.Open(file));
+        std::vector<TestEvent> expected = GetEvents(parser);
+
+        MidiCache cache;
+        CHECK(cache.Save(parser, file, cacheFile));
+        std::vector<uint8_t> good = ReadFile(cacheFile);
+
+        MidiParser loaded(options);
+        CHECK(cache.Load(loaded, file, cacheFile));
+        CHECK(GetEvents(loaded) == expected);
+
+        size_t tempo = HEADER_SIZE;
+        size_t track = tempo + 2 * TEMPO_CHANGE_SIZE;
+        uint64_t events;
+        std::memcpy(&events, good.data() + track + 16, sizeof(uint64_t));
+
+        std::vector<std::function<void(std::vector<uint8_t>&)>> corruptions = {
+            [&](std::vector<uint8_t>& bytes) { Patch<uint32_t>(bytes, tempo + 4, 0); },  // Zero tempo
+            [&](std::vector<uint8_t>& bytes) { Patch<uint32_t>(bytes, tempo, 200); },  // Ticks out of order
+            [&](std::vector<uint8_t>& bytes) { Patch<uint8_t>(bytes, (size_t)events + 8 + 4, 0xf8); },  // Unknown category on the note on
+            [&](std::vector<uint8_t>& bytes) { Patch<uint64_t>(bytes, track, ~(uint64_t)0 - 4); }  // Chunk offset that wraps around
+        };
+
+        for (const auto& corrupt : corruptions) {
+            std::vector<uint8_t> bytes = good;
+            corrupt(bytes);
+            CHECK(WriteBytes(cacheFile, bytes));
+
+            MidiParser rejected(options);
+            CHECK(!cache.Load(rejected, file, cacheFile));
+            CHECK(cache.Open(rejected, file, cacheFile));
+            CHECK(GetEvents(rejected) == expected);
+        }
+    }
+
+    std::filesystem::remove(file);
+    std::filesystem::remove(cacheFile);
+    return true;
+}
@@ -0,0 +1,101 @@
+#include "Test.h"
+#include "SyntheticMidi.h"
+
+#include <MidiParser.h>
+
+#include <cstring>
+
+// Decoding tracks as they are accessed, in any order, gives what Open decodes
+bool LazyMatchesEager() {
+    for (const std::vector<uint8_t>& file : GetTestFiles()) {
+        for (TrackStorage storage : { TrackStorage::Events, TrackStorage::Compact }) {
+            ParseOptions options;
+            options.Storage = storage;
+
+            MidiParser eager(options);
+            CHECK(eager.Open(file.data(), file.size()));
+
+            options.Lazy = true;
+            MidiParser lazy(options);
+            CHECK(lazy.Open(file.data(), file.size()));
+            CHECK(lazy.GetTrackCount() == eager.GetTrackCount());
+
+            // The last track first, before the timing
+            if (storage == TrackStorage::Compact)
+                CHECK(lazy.GetCompactTrack(lazy.GetTrackCount() - 1).GetEventCount() == eager.GetCompactTrack(eager.GetTrackCount() - 1).GetEventCount());
+
+            CHECK(lazy.GetTotalTicks() == eager.GetTotalTicks());
+            CHECK(lazy.GetDurationMicroseconds() == eager.GetDurationMicroseconds());
+            CHECK(GetEvents(lazy) == GetEvents(eager));
+        }
+    }
+
+    return true;
+}
+
+// A track that fails to decode lazily is left empty and reports why through
+// GetTrackError, without changing the result of Open
+bool LazyTrackError() {
+    SyntheticMidiDescription description;
+    description.TrackCount = 3;
+    description.EventsPerTrack = 200;
+    std::vector<uint8_t> file = GenerateSyntheticMidi(description);
+
+    // Replaces the first event of the second track with an undefined status byte
+    size_t firstSize = (size_t)file[18] << 24 | file[19] << 16 | file[20] << 8 | file[21];
+    size_t events = 14 + 8 + firstSize + 8;
+    CHECK(std::memcmp(file.data() + events - 8, "MTrk", 4) == 0);
+    file[events] = 0x00;
+    file[events + 1] = 0xf4;
+
+    for (bool lenient : { false, true }) {
+        ParseOptions options;
+        options.Lenient = lenient;
+        options.Lazy = true;
+
+        MidiParser parser(options);
+        CHECK(parser.Open(file.data(), file.size()));
+
+        CHECK(parser.GetTrack(1).GetEventCount() == 0);
+        CHECK(parser.GetTrackError(1).Code == MidiErrorCode::UnrecognizedEvent);
+        CHECK(parser.GetTrackError(1).Track == 1);
+        CHECK(!parser.GetTrackError(0) && !parser.GetTrackError(2));
+        CHECK(parser.GetTrack(2).GetEventCount() > 0);
+
+        CHECK(!parser.GetError());
+        CHECK(parser.GetErrors().size() == 1);
+    }
+
+    // An eager lenient parse gives the same error for the track
+    ParseOptions options;
+    options.Lenient = true;
+    MidiParser eager(options);
+    CHECK(eager.Open(file.data(), file.size()));
+    CHECK(eager.GetTrackError(1).Code == MidiErrorCode::UnrecognizedEvent);
+
+    return true;
+}
+
+// A file that cannot be opened leaves nothing of the previous one to decode
+bool LazyReopenFailure() {
+    ParseOptions options;
+    options.Lazy = true;
+
+    MidiParser parser(options);
+    CHECK(parser.Open(std::string(MIDI_ASSETS_DIR) + "/Type1/SpanishFlea.mid"));
+    CHECK(parser.GetTrackCount() == 2);
+
+    CHECK(!parser.Open(std::string(MIDI_ASSETS_DIR) + "/Missing.mid"));
+    CHECK(parser.GetError().Code == MidiErrorCode::CouldNotOpenFile);
+    CHECK(parser.GetTrackCount() == 0 && parser.GetFormat() == 0 && parser.GetDivision() == 0);
+    CHECK(parser.GetTotalTicks() == 0 && parser.GetDurationSeconds() == 0);
+    CHECK(parser.GetTracks().empty());
+    CHECK(parser.GetTrackName(0).empty());
+
+    size_t tracks = 0;
+    for (MidiTrack& track : parser)
+        tracks += track.GetEventCount() + 1;
+    CHECK(tracks == 0);
+
+    return true;
+}
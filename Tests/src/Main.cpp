@@ -0,0 +1,151 @@
+#include "Test.h"
+#include "SyntheticMidi.h"
+
+#include <MidiParser.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+bool CacheRejectsCorruption();
+bool LazyMatchesEager();
+bool LazyTrackError();
+bool LazyReopenFailure();
+bool OpenFailureClearsParser();
+bool ReparseReusesTracks();
+bool SequencerSeekWhileDraining();
+bool StreamMatchesFile();
+bool StreamEventTooLarge();
+bool StreamRejectsLikeOpen();
+bool WriterRoundTrip();
+bool WriterStreamEvents();
+bool WireSysExInterrupted();
+bool WireRunningStatus();
+
+struct TestCase {
+    const char* Name;
+    bool (*Run)();
+};
+
+static const TestCase s_Tests[] = {
+    { "CacheRejectsCorruption", CacheRejectsCorruption },
+    { "LazyMatchesEager", LazyMatchesEager },
+    { "LazyTrackError", LazyTrackError },
+    { "LazyReopenFailure", LazyReopenFailure },
+    { "OpenFailureClearsParser", OpenFailureClearsParser },
+    { "ReparseReusesTracks", ReparseReusesTracks },
+    { "SequencerSeekWhileDraining", SequencerSeekWhileDraining },
+    { "StreamMatchesFile", StreamMatchesFile },
+    { "StreamEventTooLarge", StreamEventTooLarge },
+    { "StreamRejectsLikeOpen", StreamRejectsLikeOpen },
+    { "WriterRoundTrip", WriterRoundTrip },
+    { "WriterStreamEvents", WriterStreamEvents },
+    { "WireSysExInterrupted", WireSysExInterrupted },
+    { "WireRunningStatus", WireRunningStatus },
+};
+
+bool TestEvent::operator==(const TestEvent& other) const {
+    return Track == other.Track && Tick == other.Tick && Category == other.Category && Type == other.Type &&
+        Channel == other.Channel && DataA == other.DataA && DataB == other.DataB && Data == other.Data;
+}
+
+TestEvent ToTestEvent(const StreamEvent& event) {
+    return { event.Track, event.Tick, event.Category, event.Type, event.Channel, event.DataA, event.DataB,
+        std::vector<uint8_t>(event.Data, event.Data + event.Size) };
+}
+
+std::vector<TestEvent> GetEvents(const MidiParser& parser) {
+    std::vector<TestEvent> events;
+
+    if (parser.GetOptions().Storage == TrackStorage::Compact) {
+        const std::vector<CompactTrack>& tracks = parser.GetCompactTracks();
+        for (uint16_t i = 0; i < (uint16_t)tracks.size(); i++) {
+            for (const CompactEvent& event : tracks[i]) {
+                if (event.IsMidi()) {
+                    events.push_back({ i, event.Tick, event.Category, event.GetMidiType(), event.GetChannel(), event.GetDataA(), event.GetDataB(), {} });
+                } else if (event.Category == EventCategory::Meta) {
+                    CompactMetaEvent meta = tracks[i].GetMetaEvent(event);
+                    events.push_back({ i, event.Tick, event.Category, meta.Type, 0, 0, 0, std::vector<uint8_t>(meta.Data, meta.Data + meta.Size) });
+                } else {
+                    CompactSysExEvent sysEx = tracks[i].GetSysExEvent(event);
+                    events.push_back({ i, event.Tick, event.Category, (uint8_t)sysEx.Packet, 0, 0, 0, std::vector<uint8_t>(sysEx.Data, sysEx.Data + sysEx.Size) });
+                }
+            }
+        }
+        return events;
+    }
+
+    const std::vector<MidiTrack>& tracks = parser.GetTracks();
+    for (uint16_t i = 0; i < (uint16_t)tracks.size(); i++) {
+        for (size_t e = 0; e < tracks[i].GetEventCount(); e++) {
+            const Event* event = tracks[i][e];
+
+            if (event->GetCategory() == EventCategory::Midi) {
+                const MidiEvent* midi = static_cast<const MidiEvent*>(event);
+                events.push_back({ i, event->GetTick(), event->GetCategory(), midi->GetType(), midi->GetChannel(), midi->GetDataA(), midi->GetDataB(), {} });
+            } else if (event->GetCategory() == EventCategory::Meta) {
+                const MetaEvent* meta = static_cast<const MetaEvent*>(event);
+                events.push_back({ i, event->GetTick(), event->GetCategory(), meta->GetType(), 0, 0, 0, std::vector<uint8_t>(meta->Data(), meta->Data() + meta->GetSize()) });
+            } else {
+                const SysExEvent* sysEx = static_cast<const SysExEvent*>(event);
+                events.push_back({ i, event->GetTick(), event->GetCategory(), (uint8_t)sysEx->GetPacket(), 0, 0, 0, std::vector<uint8_t>(sysEx->Data(), sysEx->Data() + sysEx->GetSize()) });
+            }
+        }
+    }
+    return events;
+}
+
+std::vector<uint8_t> ReadFile(const std::string& file) {
+    std::ifstream stream(file, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+std::vector<std::vector<uint8_t>> GetTestFiles() {
+    std::vector<std::string> assets;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(MIDI_ASSETS_DIR)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".mid")
+            assets.push_back(entry.path().string());
+    }
+    std::sort(assets.begin(), assets.end());
+
+    std::vector<std::vector<uint8_t>> files;
+    for (const std::string& asset : assets)
+        files.push_back(ReadFile(asset));
+
+    SyntheticMidiDescription description;
+    description.TrackCount = 3;
+    description.EventsPerTrack = 2000;
+    description.RunningStatusRatio = 0.5f;
+    description.MetaRatio = 0.05f;
+    description.SysExRatio = 0.05f;
+    files.push_back(GenerateSyntheticMidi(description));
+
+    return files;
+}
+
+// Runs the tests named on the command line, or every test
+int main(int argc, char** argv) {
+    int failed = 0, run = 0;
+
+    for (const TestCase& test : s_Tests) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+            selected |= std::strcmp(argv[i], test.Name) == 0;
+        if (!selected)
+            continue;
+
+        bool passed = test.Run();
+        std::printf("%s: %s\n", test.Name, passed ? "passed" : "FAILED");
+        failed += !passed;
+        run++;
+    }
+
+    if (run == 0) {
+        std::printf("No test matches\n");
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include "Test.h"
+#include "SyntheticMidi.h"
+
+#include <MidiParser.h>
+
+#include <cstdlib>
+#include <new>
+
+static size_t s_Allocations = 0;
+
+void* operator new(size_t size) {
+    s_Allocations++;
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+// A parser that opens one file after another gives what a new parser does,
+// and once it has parsed a file, parsing it again does not allocate
+bool ReparseReusesTracks() {
+    std::vector<std::vector<uint8_t>> files = GetTestFiles();
+
+    SyntheticMidiDescription description;
+    description.TrackCount = 64;
+    description.EventsPerTrack = 500;
+    description.MetaRatio = 0.05f;
+    files.push_back(GenerateSyntheticMidi(description));
+
+    for (TrackStorage storage : { TrackStorage::Events, TrackStorage::Compact }) {
+        ParseOptions options;
+        options.Storage = storage;
+        MidiParser reused(options);
+
+        for (const std::vector<uint8_t>& file : files) {
+            MidiParser fresh(options);
+            CHECK(fresh.Open(file.data(), file.size()));
+            CHECK(reused.Open(file.data(), file.size()));
+            CHECK(GetEvents(reused) == GetEvents(fresh));
+
+            size_t before = s_Allocations;
+            CHECK(reused.Open(file.data(), file.size()));
+            CHECK(s_Allocations == before);
+        }
+    }
+
+    return true;
+}
+
+// A failed Open leaves nothing of the previous file, whether the header or a
+// track is broken, and the parser still opens the next file normally
+bool OpenFailureClearsParser() {
+    std::vector<uint8_t> file = GetTestFiles().back();
+
+    std::vector<uint8_t> badHeader = file;
+    badHeader[9] = 5;  // Format 5
+
+    std::vector<uint8_t> badTrack = file;
+    badTrack[14 + 8 + 1] = 0xf4;  // Undefined status in the first event
+
+    MidiParser fresh;
+    CHECK(fresh.Open(file.data(), file.size()));
+    std::vector<TestEvent> expected = GetEvents(fresh);
+
+    for (const std::vector<uint8_t>* broken : { &badHeader, &badTrack }) {
+        MidiParser parser;
+        CHECK(parser.Open(file.data(), file.size()));
+        CHECK(!parser.Open(broken->data(), broken->size()));
+        CHECK(parser.GetError());
+
+        CHECK(parser.GetFormat() == 0 && parser.GetTrackCount() == 0 && parser.GetDivision() == 0);
+        CHECK(parser.GetTotalTicks() == 0 && parser.GetDurationMicroseconds() == 0);
+        CHECK(parser.GetTempoMap().GetChanges().empty());
+        CHECK(parser.GetTracks().empty());
+
+        CHECK(parser.Open(file.data(), file.size()));
+        CHECK(GetEvents(parser) == expected);
+    }
+
+    return true;
+}
@@ -0,0 +1,110 @@
+#include "Test.h"
+#include "SyntheticMidi.h"
+
+#include <MidiParser.h>
+#include <MidiSequencer.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+struct QueuedEvent {
+    uint32_t Tick;
+    uint16_t Track;
+    uint8_t DataA;
+
+    inline bool operator==(const QueuedEvent& other) const { return Tick == other.Tick && Track == other.Track && DataA == other.DataA; }
+};
+
+// Each round fills the queue, then seeks twice: the consumer drops the first
+// run while the second seek queues the next one behind it. That run must still
+// reach the consumer whole and from its first event.
+bool SequencerSeekWhileDraining() {
+    SyntheticMidiDescription description;
+    description.TrackCount = 2;
+    description.EventsPerTrack = 1000;
+    std::vector<uint8_t> file = GenerateSyntheticMidi(description);
+
+    MidiParser parser;
+    CHECK(parser.Open(file.data(), file.size()));
+
+    const uint64_t forever = (uint64_t)1 << 62;
+    const size_t capacity = 1024;
+
+    // Everything in order, as one uninterrupted playback queues it
+    std::vector<QueuedEvent> expected;
+    {
+        MidiSequencer sequencer(parser, capacity);
+        sequencer.SetLookAhead(forever);
+        sequencer.Start(0);
+
+        SequencedEvent event;
+        while (!sequencer.IsFinished()) {
+            sequencer.Update(0);
+            while (sequencer.Pop(event))
+                expected.push_back({ event.Tick, event.Track, event.DataA });
+        }
+    }
+    CHECK(expected.size() > capacity);
+
+    MidiSequencer sequencer(parser, capacity);
+    sequencer.SetLookAhead(forever);
+    sequencer.Start(0);
+
+    std::atomic<bool> done{ false }, failed{ false };
+    std::atomic<uint32_t> completed{ 0 };  // Last generation received whole
+
+    std::thread consumer([&]() {
+        SequencedEvent event;
+        uint32_t generation = 0;
+        size_t received = 0;  // Events of generation received so far
+
+        while (!done.load(std::memory_order_acquire)) {
+            if (!sequencer.Pop(event)) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (event.Generation != generation) {
+                if (event.Generation < generation)
+                    failed = true;
+                generation = event.Generation;
+                received = 0;
+            }
+
+            if (received >= expected.size() || !(expected[received] == QueuedEvent{ event.Tick, event.Track, event.DataA }))
+                failed = true;  // The start of the run was dropped
+
+            if (++received == expected.size())
+                completed.store(generation, std::memory_order_release);
+        }
+    });
+
+    const uint32_t rounds = 50;
+    bool timedOut = false;
+    for (uint32_t round = 1; round <= rounds && !failed && !timedOut; round++) {
+        sequencer.Update(0);
+        sequencer.Seek(0, 0);
+        std::this_thread::yield();
+        sequencer.Seek(0, 0);
+
+        uint32_t generation = round * 2;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (completed.load(std::memory_order_acquire) != generation && !failed) {
+            sequencer.Update(0);
+            std::this_thread::yield();
+
+            if (std::chrono::steady_clock::now() > deadline) {
+                timedOut = true;  // The run never reached the consumer
+                break;
+            }
+        }
+    }
+
+    done = true;
+    consumer.join();
+
+    CHECK(!failed);
+    CHECK(!timedOut);
+    return true;
+}
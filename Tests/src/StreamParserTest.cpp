@@ -0,0 +1,98 @@
+#include "Test.h"
+#include "SyntheticMidi.h"
+
+#include <MidiParser.h>
+#include <MidiStreamParser.h>
+
+#include <algorithm>
+
+// Feeds file in slices of sliceSize bytes and collects every event until the stream stops
+static MidiStreamParser::Status StreamFile(MidiStreamParser& parser, const std::vector<uint8_t>& file, size_t sliceSize, std::vector<TestEvent>& events) {
+    size_t fed = 0;
+    StreamEvent event;
+
+    for (;;) {
+        MidiStreamParser::Status status = parser.Next(event);
+
+        if (status == MidiStreamParser::Status::Event) {
+            events.push_back(ToTestEvent(event));
+        } else if (status == MidiStreamParser::Status::NeedMoreData) {
+            if (fed == file.size()) {
+                parser.FinishInput();
+                continue;
+            }
+
+            size_t size = std::min(sliceSize, file.size() - fed);
+            if (!parser.Feed(file.data() + fed, size))
+                return MidiStreamParser::Status::Error;
+            fed += size;
+        } else if (status != MidiStreamParser::Status::TrackEnd) {
+            return status;
+        }
+    }
+}
+
+// Streaming a file in slices of any size gives the events Open does
+bool StreamMatchesFile() {
+    for (const std::vector<uint8_t>& file : GetTestFiles()) {
+        MidiParser parser;
+        CHECK(parser.Open(file.data(), file.size()));
+        std::vector<TestEvent> expected = GetEvents(parser);
+
+        for (size_t sliceSize : { (size_t)1, (size_t)7, (size_t)4096, file.size() }) {
+            MidiStreamParser stream;
+            std::vector<TestEvent> events;
+
+            CHECK(StreamFile(stream, file, sliceSize, events) == MidiStreamParser::Status::End);
+            CHECK(stream.GetFormat() == parser.GetFormat() && stream.GetDivision() == parser.GetDivision());
+            CHECK(events == expected);
+        }
+    }
+
+    return true;
+}
+
+// A SysEx message larger than the buffer limit stops the stream with EventTooLarge
+bool StreamEventTooLarge() {
+    SyntheticMidiDescription description;
+    description.EventsPerTrack = 100;
+    description.SysExRatio = 0.5f;
+    description.SysExSize = 256;
+    std::vector<uint8_t> file = GenerateSyntheticMidi(description);
+
+    MidiStreamParser stream(128);
+    std::vector<TestEvent> events;
+    CHECK(StreamFile(stream, file, 16, events) == MidiStreamParser::Status::Error);
+    CHECK(stream.GetError().Code == MidiErrorCode::EventTooLarge);
+
+    MidiStreamParser large(1024);
+    events.clear();
+    CHECK(StreamFile(large, file, 16, events) == MidiStreamParser::Status::End);
+
+    return true;
+}
+
+// Headers Open rejects are rejected with the same error
+bool StreamRejectsLikeOpen() {
+    std::vector<uint8_t> original = GetTestFiles().back();
+
+    // Format 2, SMPTE division, and both
+    for (int patch = 1; patch <= 3; patch++) {
+        std::vector<uint8_t> file = original;
+        if (patch & 1)
+            file[9] = 2;
+        if (patch & 2)
+            file[12] = 0xe7;
+
+        MidiParser parser;
+        CHECK(!parser.Open(file.data(), file.size()));
+
+        MidiStreamParser stream;
+        std::vector<TestEvent> events;
+        CHECK(StreamFile(stream, file, 7, events) == MidiStreamParser::Status::Error);
+        CHECK(stream.GetError().Code == parser.GetError().Code);
+        CHECK(events.empty());
+    }
+
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <MidiEvent.h>
+#include <MidiStreamParser.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class MidiParser;
+
+// Fails the running test, printing the condition and where it is
+#define CHECK(x) if (!(x)) { std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); return false; }
+
+// An event with its payload copied, so the events of any parser or storage can be compared
+struct TestEvent {
+    uint16_t Track;
+    uint32_t Tick;
+    EventCategory Category;
+    uint8_t Type;  // MidiEventType, MetaEventType or SysExPacket, as in StreamEvent
+    uint8_t Channel;
+    uint8_t DataA;
+    uint8_t DataB;
+    std::vector<uint8_t> Data;
+
+    bool operator==(const TestEvent& other) const;
+    inline bool operator!=(const TestEvent& other) const { return !(*this == other); }
+};
+
+TestEvent ToTestEvent(const StreamEvent& event);
+std::vector<TestEvent> GetEvents(const MidiParser& parser);  // Every track in order, from either storage
+
+// The example assets and synthetic files with running status, meta events and SysEx
+std::vector<std::vector<uint8_t>> GetTestFiles();
+std::vector<uint8_t> ReadFile(const std::string& file);  // Empty if it cannot be read
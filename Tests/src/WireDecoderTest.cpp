@@ -0,0 +1,83 @@
+#include "Test.h"
+
+#include <MidiWireDecoder.h>
+
+// Decodes the slices in order. Each message becomes a TestEvent whose tick is the slice's index.
+static std::vector<TestEvent> Decode(MidiWireDecoder& decoder, const std::vector<std::vector<uint8_t>>& slices) {
+    std::vector<TestEvent> events;
+
+    for (size_t i = 0; i < slices.size(); i++) {
+        decoder.Feed(slices[i].data(), slices[i].size(), i, [&](const WireEvent& event) {
+            events.push_back({ 0, (uint32_t)event.Time, event.Category, event.Type, event.Channel, event.DataA, event.DataB,
+                std::vector<uint8_t>(event.Data, event.Data + event.Size) });
+        });
+    }
+
+    return events;
+}
+
+static TestEvent Midi(uint32_t slice, MidiEventType type, uint8_t channel, uint8_t dataA, uint8_t dataB) {
+    return { 0, slice, EventCategory::Midi, type, channel, dataA, dataB, {} };
+}
+
+static TestEvent System(uint32_t slice, SystemMessage message) {
+    return { 0, slice, EventCategory::System, (uint8_t)message, 0, 0, 0, {} };
+}
+
+static TestEvent SysEx(uint32_t slice, SysExPacket packet, std::vector<uint8_t> data) {
+    EventCategory category = packet == SysExPacket::First || packet == SysExPacket::Complete ? EventCategory::SysEx : EventCategory::EndSysEx;
+    return { 0, slice, category, (uint8_t)packet, 0, 0, 0, data };
+}
+
+// Real-time bytes inside a SysEx message come out on their own, between
+// packets of the message, in one slice or at the edge of a slice
+bool WireSysExInterrupted() {
+    MidiWireDecoder decoder;
+    std::vector<TestEvent> events = Decode(decoder, { { 0xf0, 0x01, 0x02, 0xf8, 0x03, 0x04, 0xf7 } });
+    CHECK(events == std::vector<TestEvent>({
+        SysEx(0, SysExPacket::First, { 0x01, 0x02 }),
+        System(0, SystemMessage::Clock),
+        SysEx(0, SysExPacket::Last, { 0x03, 0x04, 0xf7 }) }));
+
+    decoder.Reset();
+    events = Decode(decoder, { { 0xf0, 0x01 }, { 0xfe, 0x02 }, { 0x03 }, { 0xfa, 0xf7 } });
+    CHECK(events == std::vector<TestEvent>({
+        SysEx(0, SysExPacket::First, { 0x01 }),
+        System(1, SystemMessage::ActiveSensing),
+        SysEx(1, SysExPacket::Continuation, { 0x02 }),
+        SysEx(2, SysExPacket::Continuation, { 0x03 }),
+        System(3, SystemMessage::Start),
+        SysEx(3, SysExPacket::Last, { 0xf7 }) }));
+
+    // Undefined real-time bytes are dropped without becoming part of the message
+    decoder.Reset();
+    events = Decode(decoder, { { 0xf0, 0x01, 0xf9, 0x02, 0xfd, 0xf7 } });
+    CHECK(events == std::vector<TestEvent>({
+        SysEx(0, SysExPacket::First, { 0x01 }),
+        SysEx(0, SysExPacket::Continuation, { 0x02 }),
+        SysEx(0, SysExPacket::Last, { 0xf7 }) }));
+
+    // A status byte cuts the message short; no F7 is added
+    decoder.Reset();
+    events = Decode(decoder, { { 0xf0, 0x01, 0x02, 0x90, 0x3c, 0x40 } });
+    CHECK(events == std::vector<TestEvent>({
+        SysEx(0, SysExPacket::Complete, { 0x01, 0x02 }),
+        Midi(0, MidiEventType::NoteOn, 0, 0x3c, 0x40) }));
+
+    return true;
+}
+
+// Real-time bytes inside a channel message leave it and its running status intact
+bool WireRunningStatus() {
+    MidiWireDecoder decoder;
+    std::vector<TestEvent> events = Decode(decoder, { { 0x91, 0x3c, 0xf8, 0x40, 0x3e }, { 0x00, 0xc2, 0x05, 0x06 } });
+    CHECK(events == std::vector<TestEvent>({
+        System(0, SystemMessage::Clock),
+        Midi(0, MidiEventType::NoteOn, 1, 0x3c, 0x40),
+        Midi(1, MidiEventType::NoteOff, 1, 0x3e, 0x00),  // Velocity 0
+        Midi(1, MidiEventType::ProgramChange, 2, 0x05, 0x00),
+        Midi(1, MidiEventType::ProgramChange, 2, 0x06, 0x00) }));
+    CHECK(decoder.GetDroppedBytes() == 0);
+
+    return true;
+}
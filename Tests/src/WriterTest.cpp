@@ -0,0 +1,81 @@
+#include "Test.h"
+
+#include <MidiParser.h>
+#include <MidiStreamParser.h>
+#include <MidiWriter.h>
+
+#include <list>
+
+// Writing a parsed file and parsing it again gives the same events, with
+// either storage and with or without running status
+bool WriterRoundTrip() {
+    for (const std::vector<uint8_t>& file : GetTestFiles()) {
+        for (TrackStorage storage : { TrackStorage::Events, TrackStorage::Compact }) {
+            ParseOptions options;
+            options.Storage = storage;
+
+            MidiParser parser(options);
+            CHECK(parser.Open(file.data(), file.size()));
+            std::vector<TestEvent> expected = GetEvents(parser);
+
+            for (bool runningStatus : { false, true }) {
+                MidiWriter writer;
+                writer.SetRunningStatus(runningStatus);
+
+                std::vector<uint8_t> output;
+                CHECK(writer.Write(parser, output));
+                CHECK(output.size() == writer.ComputeSize(parser));
+
+                // Into a buffer: exactly the same bytes, and nothing if it is too small
+                std::vector<uint8_t> buffer(output.size());
+                CHECK(writer.Write(parser, buffer.data(), buffer.size()) == output.size());
+                CHECK(buffer == output);
+                CHECK(writer.Write(parser, buffer.data(), buffer.size() - 1) == 0);
+
+                MidiParser reparsed(options);
+                CHECK(reparsed.Open(output.data(), output.size()));
+                CHECK(reparsed.GetFormat() == parser.GetFormat() && reparsed.GetDivision() == parser.GetDivision());
+                CHECK(GetEvents(reparsed) == expected);
+            }
+        }
+    }
+
+    return true;
+}
+
+// Streamed events written after the stream has moved on, with their payloads
+// copied as the header asks, give the same file as the parsed tracks
+bool WriterStreamEvents() {
+    for (const std::vector<uint8_t>& file : GetTestFiles()) {
+        MidiParser parser;
+        CHECK(parser.Open(file.data(), file.size()));
+
+        MidiStreamParser stream;
+        CHECK(stream.Feed(file.data(), file.size()));
+        stream.FinishInput();
+
+        std::vector<StreamEvent> events;
+        std::list<std::vector<uint8_t>> payloads;  // Stable addresses for Data
+        StreamEvent event;
+        MidiStreamParser::Status status;
+        while ((status = stream.Next(event)) != MidiStreamParser::Status::End) {
+            CHECK(status != MidiStreamParser::Status::Error && status != MidiStreamParser::Status::NeedMoreData);
+            if (status != MidiStreamParser::Status::Event && status != MidiStreamParser::Status::TrackEnd)
+                continue;  // The end of each track is kept for its length
+
+            if (event.Size > 0) {
+                payloads.emplace_back(event.Data, event.Data + event.Size);
+                event.Data = payloads.back().data();
+            }
+            events.push_back(event);
+        }
+
+        MidiWriter writer;
+        std::vector<uint8_t> expected, output;
+        CHECK(writer.Write(parser, expected));
+        CHECK(writer.Write(events, stream.GetFormat(), stream.GetDivision(), output));
+        CHECK(output == expected);
+    }
+
+    return true;
+}